@@ -0,0 +1,417 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+
+#include <Magick++.h>
+
+#include "ImageResizer.h"
+#include "Size.h"
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+using namespace std;
+
+/**
+ * Performance regression runner.
+ *
+ * --generate writes fixed synthetic corpus into work directory.
+ * --mode <mode> resizes corpus with given Size::ResizeMode through 
+ * ImageResizer::create and compares outputs with golden images (SSIM) 
+ * and wall time / peak RSS with stored baseline. With --update outputs 
+ * and measurements are stored as new golden images and baseline.
+ * Without golden images or baseline the check exits with SKIP_CODE.
+ */
+
+// Exit code of check without golden data, mapped to skipped test by CTest
+static const int SKIP_CODE = 77;
+
+// Corpus image description
+struct CorpusImage
+{
+	const char *name;
+	unsigned int width;
+	unsigned int height;
+	bool alpha;
+};
+
+// Fixed corpus: large landscape, portrait, alpha and image smaller than box
+static const CorpusImage CORPUS[] = {
+	{ "landscape", 3000, 2000, false },
+	{ "portrait", 1200, 1800, false },
+	{ "alpha", 800, 800, true },
+	{ "small", 320, 200, false }
+};
+
+static const int CORPUS_SIZE = sizeof(CORPUS) / sizeof(CORPUS[0]);
+
+double utcms()
+{
+	timeval tim;
+    gettimeofday(&tim, NULL);
+
+    return tim.tv_sec * 1000.0 + (tim.tv_usec / 1000.0);
+}
+
+// Peak resident set size of this process in kilobytes
+long peakRssKb()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return usage.ru_maxrss;
+}
+
+string corpusPath(const string &work, const CorpusImage &image)
+{
+	return (fs::path(work) / "corpus" / (string(image.name) + ".png")).native();
+}
+
+string goldenPath(const string &data, const string &mode, const CorpusImage &image)
+{
+	return (fs::path(data) / "golden" / (mode + "-" + image.name + ".png")).native();
+}
+
+string baselinePath(const string &data, const string &mode)
+{
+	return (fs::path(data) / "baseline" / (mode + ".txt")).native();
+}
+
+/**
+ * Write synthetic corpus: gradients, high frequency pattern and 
+ * pseudo random noise with fixed seed
+ */
+void generate(const string &work)
+{
+	fs::create_directories(fs::path(work) / "corpus");
+
+	unsigned int seed = 12345;
+
+	for (int i = 0; i < CORPUS_SIZE; ++i)
+	{
+		const CorpusImage &desc = CORPUS[i];
+
+		Magick::Image image(Magick::Geometry(desc.width, desc.height), Magick::Color("white"));
+		image.matte(desc.alpha);
+		image.modifyImage();
+
+		for (unsigned int y = 0; y < desc.height; ++y)
+		{
+			Magick::PixelPacket *row = image.setPixels(0, y, desc.width, 1);
+
+			for (unsigned int x = 0; x < desc.width; ++x)
+			{
+				seed = seed * 1103515245 + 12345;
+				double noise = ((seed >> 16) & 0xff) / 255.0 * 0.1;
+
+				double fx = (double)x / desc.width;
+				double fy = (double)y / desc.height;
+				double pattern = 0.5 + 0.5 * sin(x * 0.35) * cos(y * 0.2);
+
+				row[x].red = (Magick::Quantum)(MaxRGB * min(1.0, fx * 0.9 + noise));
+				row[x].green = (Magick::Quantum)(MaxRGB * min(1.0, fy * 0.6 + pattern * 0.3 + noise));
+				row[x].blue = (Magick::Quantum)(MaxRGB * min(1.0, pattern * 0.9 + noise));
+				row[x].opacity = desc.alpha ? (Magick::Quantum)(MaxRGB * fx) : 0;
+			}
+
+			image.syncPixels();
+		}
+
+		image.write(corpusPath(work, desc));
+	}
+}
+
+/**
+ * Luma and alpha planes of image, normalized to 0..1
+ */
+void planes(const Magick::Image &image, vector<double> &luma, vector<double> &alpha)
+{
+	luma.resize(image.columns() * image.rows());
+	alpha.resize(image.columns() * image.rows());
+
+	for (unsigned int y = 0; y < image.rows(); ++y)
+	{
+		const Magick::PixelPacket *row = image.getConstPixels(0, y, image.columns(), 1);
+
+		for (unsigned int x = 0; x < image.columns(); ++x)
+		{
+			size_t i = y * image.columns() + x;
+			luma[i] = (0.299 * row[x].red + 0.587 * row[x].green + 0.114 * row[x].blue) / MaxRGB;
+			alpha[i] = 1.0 - (double)row[x].opacity / MaxRGB;
+		}
+	}
+}
+
+/**
+ * Mean structural similarity of plane over 8x8 windows with stride 4
+ */
+double ssim(const vector<double> &a, const vector<double> &b, unsigned int width, unsigned int height)
+{
+	const unsigned int window = 8;
+	const double c1 = 0.01 * 0.01;
+	const double c2 = 0.03 * 0.03;
+
+	// Images smaller than window are compared as single window
+	unsigned int w = min(window, width);
+	unsigned int h = min(window, height);
+
+	double total = 0;
+	int count = 0;
+
+	for (unsigned int y = 0; y + h <= height; y += 4)
+	{
+		for (unsigned int x = 0; x + w <= width; x += 4)
+		{
+			double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+
+			for (unsigned int j = 0; j < h; ++j)
+			{
+				for (unsigned int i = 0; i < w; ++i)
+				{
+					double va = a[(y + j) * width + x + i];
+					double vb = b[(y + j) * width + x + i];
+
+					sa += va;
+					sb += vb;
+					saa += va * va;
+					sbb += vb * vb;
+					sab += va * vb;
+				}
+			}
+
+			double n = w * h;
+			double ma = sa / n;
+			double mb = sb / n;
+			double va = saa / n - ma * ma;
+			double vb = sbb / n - mb * mb;
+			double cov = sab / n - ma * mb;
+
+			total += ((2 * ma * mb + c1) * (2 * cov + c2)) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+			count++;
+		}
+	}
+
+	return count ? total / count : 1;
+}
+
+/**
+ * Structural similarity of two images, mean of luma and alpha SSIM, 
+ * negative if dimensions differ. Unlike PSNR it tolerates small uniform 
+ * differences (e.g. rounding of new filter implementation) and drops 
+ * on blur, ringing, shifts and lost detail, which are visible.
+ */
+double similarity(const Magick::Image &a, const Magick::Image &b)
+{
+	if (a.columns() != b.columns() || a.rows() != b.rows())
+	{
+		return -1;
+	}
+
+	vector<double> luma_a, alpha_a, luma_b, alpha_b;
+	planes(a, luma_a, alpha_a);
+	planes(b, luma_b, alpha_b);
+
+	return (ssim(luma_a, luma_b, a.columns(), a.rows()) + ssim(alpha_a, alpha_b, a.columns(), a.rows())) / 2;
+}
+
+/**
+ * Read baseline value
+ */
+bool readBaseline(const string &path, double &time_ms, double &rss_kb)
+{
+	ifstream ins(path.c_str());
+	string key;
+	double value;
+
+	int found = 0;
+	while (ins >> key >> value)
+	{
+		if (key == "time_ms")
+		{
+			time_ms = value;
+			found++;
+		}
+		else if (key == "rss_kb")
+		{
+			rss_kb = value;
+			found++;
+		}
+	}
+
+	return found == 2;
+}
+
+/**
+ * Print one row of measurement diff, return false on regression
+ */
+bool compare(const string &metric, double baseline, double measured, double slack)
+{
+	double change = baseline > 0 ? (measured - baseline) / baseline : 0;
+	bool ok = change <= slack;
+
+	cout << "  " << setw(12) << left << metric << right << fixed << setprecision(1)
+			<< setw(12) << baseline 
+			<< setw(12) << measured 
+			<< setw(9) << showpos << change * 100 << "%" 
+			<< setw(8) << slack * 100 << "%" << noshowpos
+			<< "  " << (ok ? "ok" : "REGRESSION") << "\n";
+
+	return ok;
+}
+
+/**
+ * Run mode over corpus and compare with golden outputs and baseline
+ */
+int run(const po::variables_map &values)
+{
+	string mode = values["mode"].as<string>();
+	string work = values["work"].as<string>();
+	string data = values["data"].as<string>();
+	int iterations = values["iterations"].as<int>();
+	bool update = values.count("update") > 0;
+
+	Size size(string("a:") + mode + ",m:" + mode + ",b:#336699,s:640x480");
+	ResizeOptions options;
+
+	vector<string> outputs(CORPUS_SIZE);
+	double best = 0;
+
+	// Best of several iterations, every iteration decodes again
+	for (int iteration = 0; iteration < iterations; ++iteration)
+	{
+		double start = utcms();
+
+		for (int i = 0; i < CORPUS_SIZE; ++i)
+		{
+			ImageResizer::AutoPtr resizer = ImageResizer::create(corpusPath(work, CORPUS[i]), options);
+			resizer->resizeToBlob(outputs[i], size);
+		}
+
+		double spent = utcms() - start;
+		if (iteration == 0 || spent < best)
+		{
+			best = spent;
+		}
+	}
+
+	double rss = peakRssKb();
+
+	if (update)
+	{
+		fs::create_directories(fs::path(data) / "golden");
+		fs::create_directories(fs::path(data) / "baseline");
+
+		for (int i = 0; i < CORPUS_SIZE; ++i)
+		{
+			ofstream outs(goldenPath(data, mode, CORPUS[i]).c_str(), ios::out | ios::binary);
+			outs.write(outputs[i].data(), outputs[i].size());
+		}
+
+		ofstream outs(baselinePath(data, mode).c_str(), ios::out);
+		outs << "time_ms " << best << "\n";
+		outs << "rss_kb " << rss << "\n";
+
+		cout << "regress " << mode << ": baseline updated, time_ms " << best << ", rss_kb " << rss << "\n";
+		return 0;
+	}
+
+	double baseline_time = 0;
+	double baseline_rss = 0;
+
+	// Golden data is recorded per host, missing data skips the check instead of failing it
+	bool recorded = readBaseline(baselinePath(data, mode), baseline_time, baseline_rss);
+	for (int i = 0; i < CORPUS_SIZE && recorded; ++i)
+	{
+		recorded = fs::exists(goldenPath(data, mode, CORPUS[i]));
+	}
+
+	if (!recorded)
+	{
+		cout << "regress " << mode << ": no golden images or baseline in " << data 
+				<< ", record them with regress_update target\n";
+		return SKIP_CODE;
+	}
+
+	bool ok = true;
+	double min_ssim = values["min-ssim"].as<double>();
+
+	cout << "regress " << mode << "\n";
+	cout << "  " << setw(12) << left << "image" << right 
+			<< setw(12) << "ssim" << setw(12) << "min" << "  status\n";
+
+	for (int i = 0; i < CORPUS_SIZE; ++i)
+	{
+		Magick::Image expected(goldenPath(data, mode, CORPUS[i]));
+		Magick::Image actual(Magick::Blob(outputs[i].data(), outputs[i].size()));
+		double value = similarity(expected, actual);
+
+		bool passed = value >= min_ssim;
+		ok = ok && passed;
+
+		cout << "  " << setw(12) << left << CORPUS[i].name << right << fixed << setprecision(4)
+				<< setw(12) << value << setw(12) << min_ssim << "  " 
+				<< (passed ? "ok" : (value < 0 ? "SIZE" : "MISMATCH")) << "\n";
+	}
+
+	cout << "  " << setw(12) << left << "metric" << right 
+			<< setw(12) << "baseline" << setw(12) << "measured" 
+			<< setw(10) << "change" << setw(9) << "slack" << "  status\n";
+
+	ok = compare("time_ms", baseline_time, best, values["time-slack"].as<double>()) && ok;
+	ok = compare("rss_kb", baseline_rss, rss, values["rss-slack"].as<double>()) && ok;
+
+	return ok ? 0 : 1;
+}
+
+/**
+ * Entry point
+ */
+int main(int argc, char const *argv[])
+{
+	po::options_description description("Allowed options");
+	description.add_options()
+		("help", "produce help message")
+		("generate", "write synthetic corpus into work directory")
+		("mode", po::value<string>(), "resize mode to check: fit|stretch|pad|crop")
+		("update", "store outputs and measurements as golden images and baseline")
+		("work", po::value<string>()->default_value("regress-work"), "corpus and output directory")
+		("data", po::value<string>()->default_value("regress-data"), "golden images and baseline directory")
+		("iterations", po::value<int>()->default_value(3), "measured iterations, best one is used")
+		("time-slack", po::value<double>()->default_value(0.25), "allowed relative wall time growth")
+		("rss-slack", po::value<double>()->default_value(0.25), "allowed relative peak RSS growth")
+		("min-ssim", po::value<double>()->default_value(0.98), "minimal SSIM against golden image");
+
+	po::variables_map values;
+	po::store(po::parse_command_line(argc, argv, description), values);
+	po::notify(values);
+
+	if (values.count("help") || (!values.count("generate") && !values.count("mode")))
+	{
+		cout << description << "\n";
+		return 1;
+	}
+
+	try
+	{
+		if (values.count("generate"))
+		{
+			generate(values["work"].as<string>());
+			return 0;
+		}
+
+		return run(values);
+	}
+	catch (std::exception &ex)
+	{
+		cout << "Exception: " << ex.what() << "\n";
+		return 1;
+	}
+}
@@ -0,0 +1,501 @@
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <Magick++.h>
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+namespace alg = boost::algorithm;
+
+using namespace std;
+
+/**
+ * End-to-end scaling harness.
+ *
+ * Generates configurable synthetic corpus (resolutions, JPEG/PNG/TIFF mix, 
+ * alpha, EXIF payload with orientation) and runs phresizer binary over it 
+ * for every Size configuration and concurrency level of the sweep. 
+ * Reports images/s, MP/s, peak RSS and CPU utilization of each run 
+ * as CSV and summary table with speedup and saturation point.
+ */
+
+// Generated corpus file
+struct CorpusFile
+{
+	string path;
+	unsigned int width;
+	unsigned int height;
+};
+
+// Measured run
+struct Measurement
+{
+	string config;
+	unsigned int jobs;
+	double wall_s;
+	double cpu_s;
+	double rss_mb;
+};
+
+double utcms()
+{
+	timeval tim;
+    gettimeofday(&tim, NULL);
+
+    return tim.tv_sec * 1000.0 + (tim.tv_usec / 1000.0);
+}
+
+/**
+ * Split comma separated list
+ */
+vector<string> splitList(const string &value)
+{
+	vector<string> items;
+	alg::split(items, value, alg::is_any_of(","), alg::token_compress_on);
+
+	vector<string> result;
+	for (int i = 0; i < items.size(); ++i)
+	{
+		alg::trim(items[i]);
+		if (!items[i].empty())
+		{
+			result.push_back(items[i]);
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Minimal EXIF block: orientation and image description of given length
+ */
+Magick::Blob exifBlock(size_t payload, unsigned short orientation)
+{
+	string data("Exif\0\0", 6);
+
+	// Little endian TIFF header, IFD0 at offset 8 with two entries, data after IFD
+	const unsigned char header[] = { 'I', 'I', 42, 0, 8, 0, 0, 0, 2, 0 };
+	data.append((const char *)header, sizeof(header));
+
+	unsigned int offset = 8 + 2 + 2 * 12 + 4;
+	const unsigned char description[] = { 
+		0x0e, 0x01, 2, 0, 
+		(unsigned char)payload, (unsigned char)(payload >> 8), (unsigned char)(payload >> 16), 0,
+		(unsigned char)offset, (unsigned char)(offset >> 8), 0, 0 };
+	data.append((const char *)description, sizeof(description));
+
+	const unsigned char orient[] = { 0x12, 0x01, 3, 0, 1, 0, 0, 0, (unsigned char)orientation, 0, 0, 0 };
+	data.append((const char *)orient, sizeof(orient));
+
+	// No next IFD
+	data.append(4, '\0');
+
+	string text(payload, 'x');
+	if (payload)
+	{
+		text[payload - 1] = '\0';
+	}
+	data += text;
+
+	return Magick::Blob(data.data(), data.size());
+}
+
+/**
+ * Synthetic image: gradients, high frequency pattern and pseudo random noise
+ */
+Magick::Image synthesize(unsigned int width, unsigned int height, bool alpha, unsigned int &seed)
+{
+	Magick::Image image(Magick::Geometry(width, height), Magick::Color("white"));
+	image.matte(alpha);
+	image.modifyImage();
+
+	for (unsigned int y = 0; y < height; ++y)
+	{
+		Magick::PixelPacket *row = image.setPixels(0, y, width, 1);
+
+		for (unsigned int x = 0; x < width; ++x)
+		{
+			seed = seed * 1103515245 + 12345;
+			double noise = ((seed >> 16) & 0xff) / 255.0 * 0.1;
+
+			double fx = (double)x / width;
+			double fy = (double)y / height;
+			double pattern = 0.5 + 0.5 * sin(x * 0.05) * cos(y * 0.03);
+
+			row[x].red = (Magick::Quantum)(MaxRGB * min(1.0, fx * 0.9 + noise));
+			row[x].green = (Magick::Quantum)(MaxRGB * min(1.0, fy * 0.6 + pattern * 0.3 + noise));
+			row[x].blue = (Magick::Quantum)(MaxRGB * min(1.0, pattern * 0.9 + noise));
+			row[x].opacity = alpha ? (Magick::Quantum)(MaxRGB * fx * 0.5) : 0;
+		}
+
+		image.syncPixels();
+	}
+
+	return image;
+}
+
+/**
+ * Write corpus unless the same one already exists
+ */
+vector<CorpusFile> generate(const po::variables_map &values)
+{
+	string work = values["work"].as<string>();
+	fs::path corpus = fs::path(work) / "corpus";
+	fs::path manifest = fs::path(work) / "corpus.txt";
+
+	vector<string> resolutions = splitList(values["resolutions"].as<string>());
+	vector<string> formats = splitList(values["formats"].as<string>());
+	unsigned int count = values["count"].as<unsigned int>();
+	unsigned int alpha_every = values["alpha-every"].as<unsigned int>();
+	unsigned int exif_bytes = values["exif-bytes"].as<unsigned int>();
+
+	ostringstream description;
+	description << values["resolutions"].as<string>() << " " << values["formats"].as<string>() << " " 
+				<< count << " " << alpha_every << " " << exif_bytes;
+
+	string existing;
+	{
+		ifstream ins(manifest.native().c_str());
+		getline(ins, existing);
+	}
+
+	bool fresh = existing != description.str();
+	if (fresh)
+	{
+		fs::remove_all(corpus);
+		fs::create_directories(corpus);
+		cout << "Generating corpus: " << description.str() << "\n";
+	}
+
+	vector<CorpusFile> files;
+	unsigned int seed = 12345;
+	unsigned int index = 0;
+
+	for (int r = 0; r < resolutions.size(); ++r)
+	{
+		Magick::Geometry geometry(resolutions[r]);
+
+		for (int f = 0; f < formats.size(); ++f)
+		{
+			string format = alg::to_upper_copy(formats[f]);
+			string extension = alg::to_lower_copy(format == "JPEG" ? string("jpg") : format);
+
+			for (unsigned int i = 0; i < count; ++i, ++index)
+			{
+				ostringstream name;
+				name << setw(5) << setfill('0') << index << "-" << resolutions[r] << "." << extension;
+
+				CorpusFile file;
+				file.path = (corpus / name.str()).native();
+				file.width = geometry.width();
+				file.height = geometry.height();
+				files.push_back(file);
+
+				if (!fresh)
+				{
+					continue;
+				}
+
+				// JPEG has no alpha channel
+				bool alpha = alpha_every && format != "JPEG" && index % alpha_every == 0;
+				Magick::Image image = synthesize(geometry.width(), geometry.height(), alpha, seed);
+
+				// Every other JPEG is rotated by EXIF orientation
+				if (exif_bytes && format == "JPEG")
+				{
+					image.profile("EXIF", exifBlock(exif_bytes, index % 2 ? 6 : 1));
+				}
+
+				image.magick(format);
+				image.write(file.path);
+			}
+		}
+	}
+
+	if (fresh)
+	{
+		ofstream outs(manifest.native().c_str(), ios::out | ios::trunc);
+		outs << description.str() << "\n";
+	}
+
+	return files;
+}
+
+/**
+ * Run phresizer and measure wall time, CPU time and peak RSS of the child
+ */
+bool measure(const string &binary, const vector<string> &args, Measurement &measurement)
+{
+	vector<char *> argv;
+	argv.push_back((char *)binary.c_str());
+	for (int i = 0; i < args.size(); ++i)
+	{
+		argv.push_back((char *)args[i].c_str());
+	}
+	argv.push_back(NULL);
+
+	double start = utcms();
+
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		execv(binary.c_str(), &argv[0]);
+		_exit(127);
+	}
+
+	int status = 0;
+	rusage usage;
+	if (wait4(pid, &status, 0, &usage) != pid)
+	{
+		return false;
+	}
+
+	measurement.wall_s = (utcms() - start) / 1000.0;
+	measurement.cpu_s = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 
+						+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+	measurement.rss_mb = usage.ru_maxrss / 1024.0;
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * Default sweep: powers of two up to core count, and core count
+ */
+vector<unsigned int> defaultJobs()
+{
+	unsigned int cores = max(1u, boost::thread::hardware_concurrency());
+
+	vector<unsigned int> jobs;
+	for (unsigned int j = 1; j < cores; j *= 2)
+	{
+		jobs.push_back(j);
+	}
+	jobs.push_back(cores);
+
+	return jobs;
+}
+
+/**
+ * Run sweep, write CSV and print summary
+ */
+int run(const po::variables_map &values, const vector<CorpusFile> &files)
+{
+	string work = values["work"].as<string>();
+	string binary = fs::absolute(values["phresizer"].as<string>()).native();
+	unsigned int repeat = max(1u, values["repeat"].as<unsigned int>());
+	unsigned int cores = max(1u, boost::thread::hardware_concurrency());
+
+	vector<unsigned int> jobs;
+	if (values.count("jobs"))
+	{
+		vector<string> items = splitList(values["jobs"].as<string>());
+		for (int i = 0; i < items.size(); ++i)
+		{
+			jobs.push_back(max(1, atoi(items[i].c_str())));
+		}
+	}
+	else
+	{
+		jobs = defaultJobs();
+	}
+
+	// "<name>=<size spec>[;<size spec>...]"
+	vector<string> configs = values["sizes"].as<vector<string> >();
+
+	vector<string> extra;
+	if (values.count("args"))
+	{
+		string args = values["args"].as<string>();
+		alg::split(extra, args, alg::is_any_of(" "), alg::token_compress_on);
+	}
+
+	double megapixels = 0;
+	for (int i = 0; i < files.size(); ++i)
+	{
+		megapixels += (double)files[i].width * files[i].height / 1e6;
+	}
+
+	string csv_path = values.count("csv") ? values["csv"].as<string>() : (fs::path(work) / "scale.csv").native();
+	ofstream csv(csv_path.c_str(), ios::out | ios::trunc);
+	csv << "config,sizes,jobs,images,megapixels,wall_s,images_per_s,mp_per_s,peak_rss_mb,cpu_s,cpu_util,speedup,efficiency\n";
+
+	cout << setw(12) << left << "config" << right 
+			<< setw(6) << "jobs" << setw(10) << "wall s" << setw(10) << "img/s" << setw(10) << "MP/s"
+			<< setw(10) << "RSS MB" << setw(8) << "CPU %" << setw(9) << "speedup" << setw(8) << "eff %" << "\n";
+
+	int result = 0;
+
+	for (int c = 0; c < configs.size(); ++c)
+	{
+		size_t separator = configs[c].find('=');
+		string name = separator == string::npos ? configs[c] : configs[c].substr(0, separator);
+		string spec = separator == string::npos ? configs[c] : configs[c].substr(separator + 1);
+
+		vector<string> sizes;
+		alg::split(sizes, spec, alg::is_any_of(";"), alg::token_compress_on);
+
+		double base_rate = 0;
+		double prev_rate = 0;
+		unsigned int saturation = 0;
+
+		for (int j = 0; j < jobs.size(); ++j)
+		{
+			fs::path dest = fs::path(work) / "out";
+
+			vector<string> args;
+			args.push_back("--source");
+			args.push_back((fs::path(work) / "corpus").native());
+			args.push_back("--dest");
+			args.push_back(dest.native());
+			args.push_back("--jobs");
+			args.push_back(boost::lexical_cast<string>(jobs[j]));
+			args.insert(args.end(), extra.begin(), extra.end());
+			args.push_back("--size");
+			args.insert(args.end(), sizes.begin(), sizes.end());
+
+			// Best of repeated runs, outputs are removed so every run writes fresh files
+			Measurement best;
+			bool measured = false;
+
+			for (unsigned int r = 0; r < repeat; ++r)
+			{
+				fs::remove_all(dest);
+
+				Measurement measurement;
+				if (!measure(binary, args, measurement))
+				{
+					cout << name << ": phresizer failed at " << jobs[j] << " jobs\n";
+					result = 1;
+					continue;
+				}
+
+				if (!measured || measurement.wall_s < best.wall_s)
+				{
+					best = measurement;
+					measured = true;
+				}
+			}
+
+			if (!measured)
+			{
+				continue;
+			}
+
+			double images_rate = best.wall_s > 0 ? files.size() / best.wall_s : 0;
+			double mp_rate = best.wall_s > 0 ? megapixels / best.wall_s : 0;
+			double util = best.wall_s > 0 ? best.cpu_s / (best.wall_s * cores) : 0;
+
+			if (base_rate == 0)
+			{
+				base_rate = images_rate / jobs[j];
+			}
+
+			double speedup = base_rate > 0 ? images_rate / base_rate : 0;
+			double efficiency = speedup / jobs[j];
+
+			// Saturated when doubling-ish concurrency adds less than 10% throughput
+			if (!saturation && prev_rate > 0 && images_rate < prev_rate * 1.1)
+			{
+				saturation = jobs[j - 1];
+			}
+			prev_rate = images_rate;
+
+			csv << name << ",\"" << spec << "\"," << jobs[j] << "," << files.size() << "," 
+				<< fixed << setprecision(3) << megapixels << "," << best.wall_s << "," 
+				<< images_rate << "," << mp_rate << "," << best.rss_mb << "," << best.cpu_s << "," 
+				<< util << "," << speedup << "," << efficiency << "\n";
+
+			cout << setw(12) << left << name << right << fixed << setprecision(1)
+					<< setw(6) << jobs[j] << setw(10) << best.wall_s << setw(10) << images_rate 
+					<< setw(10) << mp_rate << setw(10) << best.rss_mb << setw(8) << util * 100 
+					<< setw(9) << setprecision(2) << speedup << setw(8) << setprecision(0) << efficiency * 100 << "\n";
+		}
+
+		if (saturation)
+		{
+			cout << name << ": throughput saturates at " << saturation << " jobs\n";
+		}
+		else
+		{
+			cout << name << ": no saturation within sweep\n";
+		}
+	}
+
+	cout << "CSV written to " << csv_path << "\n";
+	return result;
+}
+
+/**
+ * Entry point
+ */
+int main(int argc, char const *argv[])
+{
+	vector<string> default_sizes;
+	default_sizes.push_back("thumb=a:thumb,s:200x200");
+	default_sizes.push_back("web=a:thumb,s:200x200;a:web,s:1280x1280;a:square,m:crop,s:400x400");
+
+	po::options_description description("Allowed options");
+	description.add_options()
+		("help", "produce help message")
+		("phresizer", po::value<string>()->default_value("bin/phresizer"), "phresizer binary")
+		("work", po::value<string>()->default_value("scale-work"), "corpus and output directory")
+		("resolutions", po::value<string>()->default_value("640x480,1920x1080,4000x3000"), "corpus resolutions")
+		("formats", po::value<string>()->default_value("JPEG,PNG,TIFF"), "corpus formats")
+		("count", po::value<unsigned int>()->default_value(4), "images per resolution and format")
+		("alpha-every", po::value<unsigned int>()->default_value(3), "every n-th PNG/TIFF image has alpha, 0 for none")
+		("exif-bytes", po::value<unsigned int>()->default_value(4096), "EXIF payload of JPEG images, 0 for none")
+		("jobs", po::value<string>(), "concurrency levels, e.g. 1,2,4,8 (default powers of two up to core count)")
+		("sizes", po::value<vector<string> >()->multitoken()->default_value(default_sizes, "thumb, web"), 
+			"size configurations \"<name>=<size>[;<size>...]\"")
+		("args", po::value<string>(), "extra phresizer arguments, e.g. \"--quality-tier draft\"")
+		("repeat", po::value<unsigned int>()->default_value(1), "runs per point, best one is reported")
+		("csv", po::value<string>(), "CSV output (default <work>/scale.csv)");
+
+	po::variables_map values;
+	po::store(po::parse_command_line(argc, argv, description), values);
+	po::notify(values);
+
+	if (values.count("help"))
+	{
+		cout << description << "\n";
+		return 1;
+	}
+
+	try
+	{
+		Magick::InitializeMagick(NULL);
+
+		fs::create_directories(values["work"].as<string>());
+		vector<CorpusFile> files = generate(values);
+
+		return run(values, files);
+	}
+	catch (std::exception &ex)
+	{
+		cout << "Exception: " << ex.what() << "\n";
+		return 1;
+	}
+}
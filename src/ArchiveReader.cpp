@@ -0,0 +1,79 @@
+#include "ArchiveReader.h"
+#include "TarReader.h"
+#include "ZipReader.h"
+
+#include <fstream>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+using namespace std;
+
+namespace alg = boost::algorithm;
+
+
+//-----------------------------------------------------------------------------
+ArchiveReader::AutoPtr ArchiveReader::create(const string &path)
+{
+	ifstream ins(path.c_str(), ios::in | ios::binary);
+
+	char magic[512] = { 0 };
+	ins.read(magic, sizeof(magic));
+	streamsize length = ins.gcount();
+
+	if (length >= 4 && magic[0] == 'P' && magic[1] == 'K' && magic[2] == 3 && magic[3] == 4)
+	{
+		return AutoPtr(new ZipReader(path));
+	}
+
+	// Compressed tar is recognized by gzip magic, plain tar by ustar magic
+	if ((length >= 2 && (unsigned char)magic[0] == 0x1f && (unsigned char)magic[1] == 0x8b) 
+		|| (length == 512 && string(magic + 257, 5) == "ustar"))
+	{
+		return AutoPtr(new TarReader(path));
+	}
+
+	return AutoPtr();
+}
+
+//-----------------------------------------------------------------------------
+vector<string> ArchiveReader::takeSkipped()
+{
+	vector<string> result;
+	result.swap(m_skipped);
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+void ArchiveReader::skip(const string &name, const string &reason)
+{
+	m_skipped.push_back(name + ": " + reason);
+}
+
+//-----------------------------------------------------------------------------
+bool ArchiveReader::sanitize(string &name)
+{
+	vector<string> parts;
+	alg::split(parts, name, alg::is_any_of("/\\"));
+
+	string result;
+	for (int i = 0; i < parts.size(); ++i)
+	{
+		if (parts[i].empty() || parts[i] == ".")
+		{
+			continue;
+		}
+
+		// Never write outside of destination
+		if (parts[i] == "..")
+		{
+			return false;
+		}
+
+		result += (result.empty() ? "" : "/") + parts[i];
+	}
+
+	name = result;
+	return !name.empty();
+}
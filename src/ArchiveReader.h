@@ -0,0 +1,64 @@
+#ifndef _ARCHIVE_READER_H
+#define _ARCHIVE_READER_H 
+
+#include <string>
+#include <vector>
+
+#include <boost/smart_ptr.hpp>
+
+/**
+ * Sequential reader of regular file entries of source archive. 
+ * Entries are read one by one into memory, so memory use is bounded 
+ * by the entries being processed, not by the archive size. 
+ * Implementations throw std::runtime_error on corrupt archives, 
+ * entries which can not be processed are skipped and reported.
+ */
+class ArchiveReader
+{
+public:
+	typedef boost::shared_ptr<ArchiveReader> AutoPtr;
+
+	/**
+	 * Open archive, format is detected from content: 
+	 * zip, tar or gzip compressed tar
+	 * @return null if file is not a supported archive.
+	 */
+	static AutoPtr create(const std::string &path);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~ArchiveReader() {}
+
+	/**
+	 * Read next regular file entry
+	 * @param name Archive relative entry name, never absolute and without "..".
+	 * @param data Entry content.
+	 * @return false after the last entry.
+	 */
+	virtual bool next(std::string &name, std::string &data) = 0;
+
+	/**
+	 * Take messages about entries skipped since last call, 
+	 * e.g. "a/b.jpg: unsupported compression method 12"
+	 */
+	std::vector<std::string> takeSkipped();
+
+protected:
+	/**
+	 * Record skipped entry with reason
+	 */
+	void skip(const std::string &name, const std::string &reason);
+
+	/**
+	 * Make entry name safe to use as relative output name
+	 * @return false if entry must be skipped.
+	 */
+	static bool sanitize(std::string &name);
+
+private:
+	// Messages about skipped entries
+	std::vector<std::string> m_skipped;
+};
+
+#endif
@@ -0,0 +1,609 @@
+#include "Batch.h"
+#include "ImageResizer.h"
+#include "Limits.h"
+#include "Trace.h"
+#include "Stats.h"
+#include "Metrics.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <iomanip>
+#include <typeinfo>
+#include <cstdlib>
+
+#include <cxxabi.h>
+
+#include <boost/thread/thread.hpp>
+#include <boost/bind/bind.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+
+const std::string Batch::Schedule::NAME = "name";
+const std::string Batch::Schedule::LARGEST = "largest";
+
+
+//-----------------------------------------------------------------------------
+Batch::Batch(const Config &conf, const Processor &processor, PackStore *packs)
+	:m_conf(conf)
+	,m_processor(processor)
+	,m_packs(packs)
+	,m_prefetcher(NULL)
+	,m_tuner(boost::thread::hardware_concurrency())
+	,m_files(NULL)
+	,m_archive(NULL)
+	,m_next(0)
+	,m_failed(false)
+	,m_free_cores(0)
+	,m_node_stats(m_numa.nodes())
+	,m_busy_ms(0)
+	,m_longest_ms(0)
+{
+	if (!conf.isAutoThreads())
+	{
+		return;
+	}
+
+	m_tuner.operations(conf.qualityTier(), conf.sizes());
+
+	string profile = conf.tuneProfile();
+	if (conf.isRecalibrate() || !m_tuner.load(profile))
+	{
+		if (conf.isVerbose())
+		{
+			cout << "Calibrating parallelism for " << m_tuner.cores() << " cores\n";
+		}
+
+		m_tuner.calibrate();
+		m_tuner.save(profile);
+	}
+}
+
+//-----------------------------------------------------------------------------
+Batch::NodeStats::NodeStats()
+	:files(0)
+	,bytes(0)
+	,ms(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Batch::~Batch()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+void Batch::schedule(vector<fs::path> &files)
+{
+	m_dims.clear();
+
+	if (m_conf.schedule() != Schedule::LARGEST)
+	{
+		return;
+	}
+
+	Trace::Span span("schedule", "cpu");
+
+	vector<pair<unsigned int, unsigned int> > dims(files.size(), make_pair(0u, 0u));
+
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		unsigned int width = 0;
+		unsigned int height = 0;
+
+		if (fs::is_regular_file(files[i]) && ImageResizer::ping(files[i].native(), width, height))
+		{
+			dims[i] = make_pair(width, height);
+		}
+	}
+
+	vector<size_t> order = largestFirst(dims, m_conf.sizes().size());
+
+	vector<fs::path> ordered;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		ordered.push_back(files[order[i]]);
+		m_dims.push_back(dims[order[i]]);
+	}
+
+	files.swap(ordered);
+}
+
+//-----------------------------------------------------------------------------
+vector<size_t> Batch::largestFirst(const vector<pair<unsigned int, unsigned int> > &dims, size_t sizes)
+{
+	// (negated cost, index) pairs, index keeps order of equal costs
+	vector<pair<double, size_t> > costs;
+	for (size_t i = 0; i < dims.size(); ++i)
+	{
+		double cost = (double)dims[i].first * dims[i].second * sizes;
+		costs.push_back(make_pair(-cost, i));
+	}
+
+	sort(costs.begin(), costs.end());
+
+	vector<size_t> order;
+	for (size_t i = 0; i < costs.size(); ++i)
+	{
+		order.push_back(costs[i].second);
+	}
+
+	return order;
+}
+
+//-----------------------------------------------------------------------------
+void Batch::prefetcher(Prefetcher *prefetcher)
+{
+	m_prefetcher = prefetcher;
+}
+
+//-----------------------------------------------------------------------------
+bool Batch::run(const vector<fs::path> &files)
+{
+	m_files = &files;
+	m_archive = NULL;
+
+	if (Metrics::instance().isEnabled())
+	{
+		size_t queued = 0;
+		for (size_t i = 0; i < files.size(); ++i)
+		{
+			queued += fs::is_regular_file(files[i]) ? 1 : 0;
+		}
+
+		Metrics::instance().queue(queued);
+	}
+
+	return execute();
+}
+
+//-----------------------------------------------------------------------------
+bool Batch::run(ArchiveReader &archive)
+{
+	m_files = NULL;
+	m_archive = &archive;
+
+	return execute();
+}
+
+//-----------------------------------------------------------------------------
+bool Batch::execute()
+{
+	m_next = 0;
+	m_failed = false;
+	m_free_cores = m_tuner.cores();
+	m_busy_ms = 0;
+	m_longest_ms = 0;
+
+	if (m_conf.isNuma() && m_conf.isVerbose() && m_numa.nodes() == 1)
+	{
+		cout << "Single NUMA node, only pinning threads to cores\n";
+	}
+
+	double start = Stats::now();
+
+	// Even single job runs on worker thread, so placing it never 
+	// pins or binds the main thread
+	unsigned int jobs = max(1u, m_conf.jobs());
+
+	boost::thread_group workers;
+	for (unsigned int i = 0; i < jobs; ++i)
+	{
+		workers.create_thread(boost::bind(&Batch::work, this, i));
+	}
+
+	workers.join_all();
+
+	if (m_conf.isNuma() && (m_conf.isVerbose() || m_conf.isStatsEnabled()))
+	{
+		printNodes(Stats::now() - start);
+	}
+
+	if (m_conf.isVerbose() || m_conf.isStatsEnabled())
+	{
+		printSchedule(Stats::now() - start);
+	}
+
+	return !m_failed;
+}
+
+//-----------------------------------------------------------------------------
+void Batch::work(unsigned int worker)
+{
+	if (m_conf.isNuma())
+	{
+		place(worker);
+	}
+
+	unsigned int node = worker % m_numa.nodes();
+
+	size_t index;
+
+	if (m_archive)
+	{
+		string name;
+		string data;
+		while (next(index, name, data))
+		{
+			if (!process(index, name, node, &data))
+			{
+				boost::mutex::scoped_lock lock(m_mutex);
+				m_failed = true;
+			}
+		}
+
+		return;
+	}
+
+	while (next(index))
+	{
+		string file_path = fs::absolute((*m_files)[index]).native();
+
+		// Skip directories
+		if (!fs::is_regular_file(file_path))
+		{
+			continue;
+		}
+
+		if (!process(index, file_path, node))
+		{
+			boost::mutex::scoped_lock lock(m_mutex);
+			m_failed = true;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+string Batch::errorType(const std::exception &ex)
+{
+	// Exception class name without namespace, e.g. ErrorCorruptImage
+	int status = 0;
+	char *demangled = abi::__cxa_demangle(typeid(ex).name(), NULL, NULL, &status);
+
+	string type = (status == 0 && demangled) ? demangled : typeid(ex).name();
+	free(demangled);
+
+	size_t scope = type.rfind("::");
+	return scope == string::npos ? type : type.substr(scope + 2);
+}
+
+//-----------------------------------------------------------------------------
+void Batch::printSchedule(double ms)
+{
+	// No schedule finishes before the longest file or before work is spread evenly
+	unsigned int jobs = max(1u, m_conf.jobs());
+	double bound = max(m_longest_ms, m_busy_ms / jobs);
+
+	cout << "Schedule " << m_conf.schedule() << ": makespan " << (int)ms << " ms, "
+			<< "lower bound " << (int)bound << " ms";
+
+	if (bound > 0)
+	{
+		cout << ", " << fixed << setprecision(1) << (ms / bound - 1) * 100 << "% over";
+	}
+
+	cout << "\n";
+}
+
+//-----------------------------------------------------------------------------
+bool Batch::next(size_t &index)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	if (m_failed || m_next >= m_files->size())
+	{
+		return false;
+	}
+
+	index = m_next++;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Batch::next(size_t &index, string &name, string &data)
+{
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		if (m_failed)
+		{
+			return false;
+		}
+	}
+
+	// Archive is read sequentially, one entry at a time, while 
+	// other workers keep processing entries they already hold
+	boost::mutex::scoped_lock lock(m_archive_mutex);
+
+	try
+	{
+		Trace::Span span("archive", "io");
+
+		bool found = m_archive->next(name, data);
+
+		// Entries which can not be processed do not stop the batch
+		vector<string> skipped = m_archive->takeSkipped();
+		for (size_t i = 0; i < skipped.size(); ++i)
+		{
+			print(string("Skip archive entry ") + skipped[i]);
+			Stats::instance().add("archive.skipped", 0);
+		}
+
+		if (!found)
+		{
+			return false;
+		}
+	}
+	catch (std::exception &ex)
+	{
+		print(string("Exception: ") + ex.what());
+
+		boost::mutex::scoped_lock failed_lock(m_mutex);
+		m_failed = true;
+
+		return false;
+	}
+
+	index = m_next++;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Batch::process(size_t index, const string &file, unsigned int node, const string *entry)
+{
+	double start = Stats::now();
+	unsigned int threads = 0;
+
+	if (m_conf.isAutoThreads())
+	{
+		unsigned int width = 0;
+		unsigned int height = 0;
+
+		if (entry)
+		{
+			ImageResizer::ping(entry->data(), entry->size(), width, height);
+		}
+		else if (index < m_dims.size())
+		{
+			width = m_dims[index].first;
+			height = m_dims[index].second;
+		}
+		else
+		{
+			ImageResizer::ping(file, width, height);
+		}
+
+		threads = acquire(m_tuner.threadsFor(width, height));
+		ImageResizer::threads(threads);
+	}
+
+	if (m_conf.isVerbose())
+	{
+		ostringstream line;
+		line << "Process " << file << " file";
+		if (threads)
+		{
+			line << " (" << threads << " inner threads, " << m_conf.jobs() << " jobs)";
+		}
+		print(line.str());
+	}
+
+	bool result = true;
+	bool quarantined = false;
+	try
+	{
+		// Deadline covers decode, resampling and encoding of all sizes
+		Limits::Deadline deadline("file", m_conf.fileTimeout());
+
+		Trace::Span span("file", "file");
+		span.arg("path", file);
+
+		string data;
+		if (entry)
+		{
+			m_processor.processEntry(file, entry->data(), entry->size(), m_conf.dest(), m_packs);
+		}
+		else if (m_prefetcher && m_prefetcher->take(index, data))
+		{
+			m_processor.process(file, data.data(), data.size(), m_conf.dest(), m_packs);
+		}
+		else
+		{
+			m_processor.process(file, m_conf.dest(), m_packs);
+		}
+	}
+	catch (Limits::Exceeded &ex)
+	{
+		// Offending file is set aside, rest of the batch continues
+		quarantine(file, entry, ex);
+		quarantined = true;
+	}
+	catch (std::exception &ex)
+	{
+		if (m_conf.isVerbose())
+		{
+			print(string("Exception: ") + ex.what());
+		}
+
+		if (Metrics::instance().isEnabled())
+		{
+			Metrics::instance().error(errorType(ex));
+		}
+
+		result = false;
+	}
+
+	double bytes = 0;
+	if (entry)
+	{
+		bytes = entry->size();
+	}
+	else if (Metrics::instance().isEnabled() || m_conf.isNuma())
+	{
+		boost::system::error_code error;
+		uintmax_t size = fs::file_size(file, error);
+		bytes = error ? 0 : size;
+	}
+
+	if (result && !quarantined && Metrics::instance().isEnabled())
+	{
+		Metrics::instance().file(bytes);
+	}
+
+	if (threads)
+	{
+		release(threads);
+	}
+
+	{
+		double spent = Stats::now() - start;
+
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_busy_ms += spent;
+		m_longest_ms = max(m_longest_ms, spent);
+	}
+
+	if (m_conf.isNuma())
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		NodeStats &stats = m_node_stats[node];
+		stats.files++;
+		stats.bytes += bytes;
+		stats.ms += Stats::now() - start;
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+void Batch::place(unsigned int worker)
+{
+	unsigned int node = worker % m_numa.nodes();
+
+	if (m_numa.nodes() > 1 && !m_numa.bind(node))
+	{
+		print("Can not bind worker to NUMA node");
+	}
+
+	// Inner OpenMP threads inherit worker affinity, so worker is pinned to 
+	// single core only when it has no more than one core of its node anyway, 
+	// and then runs single inner thread. With auto threads or fewer workers 
+	// than cores it keeps whole node set.
+	const vector<int> &cpus = m_numa.cpus(node);
+	unsigned int per_node = (max(1u, m_conf.jobs()) + m_numa.nodes() - 1) / m_numa.nodes();
+
+	if (!m_conf.isAutoThreads() && per_node >= cpus.size())
+	{
+		ImageResizer::threads(1);
+		m_numa.pin(cpus[(worker / m_numa.nodes()) % cpus.size()]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+void Batch::printNodes(double ms)
+{
+	cout << "NUMA nodes:\n";
+
+	for (unsigned int i = 0; i < m_node_stats.size(); ++i)
+	{
+		const NodeStats &stats = m_node_stats[i];
+		double seconds = ms / 1000.0;
+
+		cout << "node " << i << ": " << stats.files << " files, " 
+				<< fixed << setprecision(1) << stats.bytes / 1048576.0 << " MB in, "
+				<< (seconds > 0 ? stats.files / seconds : 0.0) << " files/s, "
+				<< (seconds > 0 ? stats.bytes / 1048576.0 / seconds : 0.0) << " MB/s, "
+				<< "busy " << (int)stats.ms << " ms\n";
+	}
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Batch::acquire(unsigned int wanted)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	while (m_free_cores == 0)
+	{
+		m_released.wait(lock);
+	}
+
+	// Use idle cores up to what the image can make use of
+	unsigned int count = max(1u, min(wanted, m_free_cores));
+	m_free_cores -= count;
+
+	return count;
+}
+
+//-----------------------------------------------------------------------------
+void Batch::release(unsigned int count)
+{
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_free_cores += count;
+	}
+
+	m_released.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+void Batch::quarantine(const string &file, const string *entry, const Limits::Exceeded &ex)
+{
+	print(string("Quarantine ") + file + ": " + ex.what());
+
+	Stats::instance().add(string("limit.") + ex.reason(), 0);
+
+	if (Metrics::instance().isEnabled())
+	{
+		Metrics::instance().error(string("limit_") + ex.reason());
+	}
+
+	if (m_conf.quarantine().empty())
+	{
+		return;
+	}
+
+	boost::mutex::scoped_lock lock(m_quarantine_mutex);
+
+	boost::system::error_code error;
+	// Archive entries keep relative path, so equal names in different directories do not collide
+	fs::path dir(m_conf.quarantine());
+	fs::path target = dir / (entry ? fs::path(file) : fs::path(file).filename());
+
+	fs::create_directories(target.parent_path(), error);
+	fs::remove(target, error);
+
+	if (entry)
+	{
+		ofstream out(target.native().c_str(), ios::out | ios::binary);
+		out.write(entry->data(), entry->size());
+		
+		if (!out)
+		{
+			print(string("Can not write ") + target.native());
+		}
+	}
+	else
+	{
+		fs::copy_file(file, target, error);
+
+		if (error)
+		{
+			print(string("Can not copy ") + file + " to " + target.native() + ": " + error.message());
+		}
+	}
+
+	ofstream log((dir / "quarantine.log").native().c_str(), ios::out | ios::app);
+	log << file << "\t" << ex.reason() << "\t" << ex.what() << "\n";
+}
+
+//-----------------------------------------------------------------------------
+void Batch::print(const string &line)
+{
+	boost::mutex::scoped_lock lock(m_output_mutex);
+	cout << line << "\n";
+}
@@ -0,0 +1,220 @@
+
+#ifndef _BATCH_H
+#define _BATCH_H 
+
+#include "Config.h"
+#include "Processor.h"
+#include "PackStore.h"
+#include "ParallelismTuner.h"
+#include "Numa.h"
+#include "Prefetcher.h"
+#include "ArchiveReader.h"
+#include "Limits.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <exception>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+/**
+ * Processes list of files with pool of worker threads (--jobs).
+ * With --auto-threads every file gets inner (GraphicsMagick) threads 
+ * chosen by ParallelismTuner from its pinged dimensions. Inner threads 
+ * are taken from shared budget of cores, so per-file and per-image 
+ * parallelism together never oversubscribe the machine.
+ * With --numa workers are spread over NUMA nodes and every file is 
+ * decoded, resized and encoded by a thread placed on one node.
+ * With --schedule largest files are queued by pinged cost, longest 
+ * first, so a few large files do not run alone at the end.
+ * Archive sources are read entry by entry by the workers themselves, 
+ * so at most one entry per worker is held in memory.
+ * Files exceeding pixel or time limits are quarantined and logged 
+ * with the reason while the rest of the batch continues.
+ */
+class Batch
+{
+public:
+	/**
+	 * Queue order
+	 */
+	class Schedule
+	{
+	public:
+		// Sorted by file name
+		static const std::string NAME;
+
+		// Largest pixel work first, ties by file name
+		static const std::string LARGEST;
+	};
+
+
+	/**
+	 * Create batch
+	 * @param conf Configuration.
+	 * @param processor Processor to run for each file.
+	 * @param packs Pack store, null if outputs are written as files.
+	 */
+	Batch(const Config &conf, const Processor &processor, PackStore *packs);
+
+	/**
+	 * Reorder name sorted files according to configured schedule. 
+	 * Must be called before files are handed to prefetcher.
+	 */
+	void schedule(std::vector<boost::filesystem::path> &files);
+
+	/**
+	 * Queue order of largest schedule: indexes of files by pinged pixels 
+	 * times count of sizes, largest first, equal costs in given order. 
+	 * Shared with --estimate, so it simulates the order which runs.
+	 */
+	static std::vector<size_t> largestFirst(const std::vector<std::pair<unsigned int, unsigned int> > &dims, 
+											size_t sizes);
+
+	/**
+	 * Prefetcher warming up upcoming files, null to read files on demand
+	 */
+	void prefetcher(Prefetcher *prefetcher);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~Batch();
+
+public:
+	/**
+	 * Process files
+	 * @return false if processing of some file failed, 
+	 *		remaining files are not started then.
+	 */
+	bool run(const std::vector<boost::filesystem::path> &files);
+
+	/**
+	 * Process regular file entries of archive, outputs are named 
+	 * by archive relative names
+	 * @return false if processing of some entry or reading of archive failed.
+	 */
+	bool run(ArchiveReader &archive);
+
+private:
+	Batch(const Batch &);
+
+	// Worker thread body
+	void work(unsigned int worker);
+
+	// Place worker thread on NUMA node and core
+	void place(unsigned int worker);
+
+	// Print per node throughput
+	void printNodes(double ms);
+
+	// Print makespan against ideal lower bound
+	void printSchedule(double ms);
+
+	// Error type label of exception
+	static std::string errorType(const std::exception &ex);
+
+	// Run workers over files or archive
+	bool execute();
+
+	// Take next file index, false if there are no more files
+	bool next(size_t &index);
+
+	// Read next archive entry, false if there are no more entries
+	bool next(size_t &index, std::string &name, std::string &data);
+
+	// Process one file, or archive entry if entry is not null
+	bool process(size_t index, const std::string &file, unsigned int node, const std::string *entry = NULL);
+
+	// Take up to wanted cores from budget, waits for at least one
+	unsigned int acquire(unsigned int wanted);
+
+	// Return cores to budget
+	void release(unsigned int count);
+
+	// Log file exceeding limits and copy it to quarantine directory
+	void quarantine(const std::string &file, const std::string *entry, const Limits::Exceeded &ex);
+
+	// Print line under output lock
+	void print(const std::string &line);
+
+private:
+	// Configuration
+	const Config &m_conf;
+
+	// Processor
+	const Processor &m_processor;
+
+	// Packs
+	PackStore *m_packs;
+
+	// Prefetcher
+	Prefetcher *m_prefetcher;
+
+	// Tuner, used with auto threads
+	ParallelismTuner m_tuner;
+
+	// Files to process
+	const std::vector<boost::filesystem::path> *m_files;
+
+	// Archive to process, null when processing files
+	ArchiveReader *m_archive;
+
+	// Guards archive reading
+	boost::mutex m_archive_mutex;
+
+	// Pinged dimensions by file index, empty if files were not pinged
+	std::vector<std::pair<unsigned int, unsigned int> > m_dims;
+
+	// Next file index
+	size_t m_next;
+
+	// Failure flag
+	bool m_failed;
+
+	// Free cores
+	unsigned int m_free_cores;
+
+	// Guards queue and core budget
+	boost::mutex m_mutex;
+
+	// Signals released cores
+	boost::condition_variable m_released;
+
+	// Guards console output
+	boost::mutex m_output_mutex;
+
+	// Guards quarantine directory and log
+	boost::mutex m_quarantine_mutex;
+
+	// NUMA topology
+	Numa m_numa;
+
+	// Per node throughput
+	struct NodeStats
+	{
+		NodeStats();
+
+		// Processed files
+		unsigned long files;
+
+		// Bytes read
+		double bytes;
+
+		// Busy time in milliseconds
+		double ms;
+	};
+
+	std::vector<NodeStats> m_node_stats;
+
+	// Sum of per file processing times
+	double m_busy_ms;
+
+	// Longest file processing time
+	double m_longest_ms;
+};
+
+#endif
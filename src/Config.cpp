@@ -1,6 +1,14 @@
 
 #include "Config.h"
 #include "Size.h"
+#include "ImageResizer.h"
+#include "PackStore.h"
+#include "ParallelismTuner.h"
+#include "CostModel.h"
+#include "Batch.h"
+#include "ArchiveReader.h"
+
+#include <iostream>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
@@ -22,6 +30,37 @@ const char *Config::Options::VERBOSE = "verbose";
 const char *Config::Options::SRC_SIZE = "src-size";
 const char *Config::Options::META = "meta";
 const char *Config::Options::CONTENTS = "contents";
+const char *Config::Options::QUALITY_TIER = "quality-tier";
+const char *Config::Options::STATS = "stats";
+const char *Config::Options::PYRAMID = "pyramid";
+const char *Config::Options::NO_AUTO_ORIENT = "no-auto-orient";
+const char *Config::Options::SHARD_LEVELS = "shard-levels";
+const char *Config::Options::SHARD_DIGITS = "shard-digits";
+const char *Config::Options::PACK = "pack";
+const char *Config::Options::PACK_FILE = "pack-file";
+const char *Config::Options::EXTRACT = "extract";
+const char *Config::Options::FILTER = "filter";
+const char *Config::Options::EXIF_OUT = "exif-out";
+const char *Config::Options::TRACE = "trace";
+const char *Config::Options::JOBS = "jobs";
+const char *Config::Options::AUTO_THREADS = "auto-threads";
+const char *Config::Options::TUNE_PROFILE = "tune-profile";
+const char *Config::Options::RECALIBRATE = "recalibrate";
+const char *Config::Options::NUMA = "numa";
+const char *Config::Options::PREFETCH = "prefetch";
+const char *Config::Options::PREFETCH_BUDGET = "prefetch-budget";
+const char *Config::Options::PREFETCH_BUFFER = "prefetch-buffer";
+const char *Config::Options::MASTER_CACHE = "master-cache";
+const char *Config::Options::MASTER_SIZE = "master-size";
+const char *Config::Options::ESTIMATE = "estimate";
+const char *Config::Options::COST_PROFILE = "cost-profile";
+const char *Config::Options::SCHEDULE = "schedule";
+const char *Config::Options::METRICS_FILE = "metrics-file";
+const char *Config::Options::METRICS_INTERVAL = "metrics-interval";
+const char *Config::Options::MAX_MEGAPIXELS = "max-megapixels";
+const char *Config::Options::DECODE_TIMEOUT = "decode-timeout";
+const char *Config::Options::FILE_TIMEOUT = "file-timeout";
+const char *Config::Options::QUARANTINE = "quarantine";
 
 
 //-----------------------------------------------------------------------------
@@ -35,15 +74,53 @@ Config::Config(int argc, char const*argv[])
 	m_config_description.add_options()
 	    (Options::HELP, "produce help message")
 	    (Options::VERSION, "print version")
-	    (Options::SOURCE, po::value<string>(), "set source directory path")
+	    (Options::SOURCE, po::value<string>(), "set source directory or tar/zip archive path")
 	    (Options::DEST, po::value<string>(), "set destination directory")
 	    (Options::SIZE, po::value<vector<Size> >()->multitoken(), 
-	    	"add resize operation, format:\n [a:<alias>,][m:fit|stretch|pad|crop,][b:<bgcolor>,][u:true|false,]s:<width>x<height>")
+	    	"add resize operation, format:\n [a:<alias>,][m:fit|stretch|pad|crop,][b:<bgcolor>,][u:true|false,]"
+	    	"[f:box|triangle|catrom|lanczos,]s:<width>x<height>")
 	    (Options::CONF, po::value<string>(), "read configuration form specified file")
 	    (Options::VERBOSE, "verbose output")
 	    (Options::META, "extract meta information from files and store in separate file")
 	    (Options::CONTENTS, "write output contents")
-	    (Options::SRC_SIZE, po::value<string>(), "hint to open file at reduced size");
+	    (Options::SRC_SIZE, po::value<string>(), "hint to open file at reduced size")
+	    (Options::QUALITY_TIER, po::value<string>()->default_value(ImageResizer::QualityTier::NORMAL), 
+	    	"resampling quality for sizes without filter: draft|normal|high")
+	    (Options::STATS, "print cost of resize operations")
+	    (Options::PYRAMID, "build image pyramid once per file and resample sizes from nearest larger level")
+	    (Options::NO_AUTO_ORIENT, "keep stored pixel orientation instead of applying exif orientation")
+	    (Options::SHARD_LEVELS, po::value<unsigned int>()->default_value(0), 
+	    	"spread outputs over levels of subdirectories named by hash of file name, e.g. ab/cd/<name>")
+	    (Options::SHARD_DIGITS, po::value<unsigned int>()->default_value(2), "hex digits per shard level, fan-out is 16^digits")
+	    (Options::PACK, po::value<string>(), "write outputs into append-only packs with index, one per alias|run")
+	    (Options::PACK_FILE, po::value<string>(), "pack path without extension, for --extract")
+	    (Options::EXTRACT, po::value<string>(), "write pack entry with specified name to stdout")
+	    (Options::FILTER, "read one image from stdin and write results to stdout, single result raw, "
+	    	"several as frames: \"<alias> <format> <length>\\n\" followed by <length> bytes")
+	    (Options::EXIF_OUT, po::value<string>(), "in filter mode write exif info to this file, e.g. /dev/fd/3")
+	    (Options::TRACE, po::value<string>(), "write per file, per stage timeline to file in Chrome trace format")
+	    (Options::JOBS, po::value<unsigned int>()->default_value(1), "count of files processed in parallel")
+	    (Options::AUTO_THREADS, "choose inner GraphicsMagick threads per file from its dimensions")
+	    (Options::TUNE_PROFILE, po::value<string>()->default_value(ParallelismTuner::defaultProfilePath()), 
+	    	"cached parallelism profile of this host")
+	    (Options::RECALIBRATE, "recalibrate parallelism profile and cost model")
+	    (Options::NUMA, "pin workers to cores, keep each file on one NUMA node (Linux)")
+	    (Options::PREFETCH, po::value<unsigned int>()->default_value(0), "count of upcoming files to read ahead")
+	    (Options::PREFETCH_BUDGET, po::value<unsigned int>()->default_value(256), "maximum MB read ahead")
+	    (Options::PREFETCH_BUFFER, "read ahead into memory buffers instead of kernel page cache")
+	    (Options::MASTER_CACHE, po::value<string>(), "cache reduced resolution master per source in directory and resample from it")
+	    (Options::MASTER_SIZE, po::value<unsigned int>()->default_value(2048), "long edge of cached masters")
+	    (Options::ESTIMATE, "only ping files and predict time, memory and output bytes of the run")
+	    (Options::COST_PROFILE, po::value<string>()->default_value(CostModel::defaultProfilePath()), 
+	    	"cached cost model of this host")
+	    (Options::SCHEDULE, po::value<string>()->default_value(Batch::Schedule::NAME), 
+	    	"queue order of files: name|largest (pinged pixels times sizes, longest first)")
+	    (Options::METRICS_FILE, po::value<string>(), "periodically rewrite Prometheus textfile with progress and throughput")
+	    (Options::METRICS_INTERVAL, po::value<unsigned int>()->default_value(5), "seconds between metrics file rewrites")
+	    (Options::MAX_MEGAPIXELS, po::value<double>()->default_value(0), "skip files declaring more megapixels, 0 for no limit")
+	    (Options::DECODE_TIMEOUT, po::value<unsigned int>()->default_value(0), "cancel decode of file after ms, 0 for no limit")
+	    (Options::FILE_TIMEOUT, po::value<unsigned int>()->default_value(0), "cancel processing of file after ms, 0 for no limit")
+	    (Options::QUARANTINE, po::value<string>(), "copy files exceeding limits to directory and log reasons to its quarantine.log");
 
 	po::store(po::parse_command_line(argc, argv, m_config_description), m_config_values);
 
@@ -56,6 +133,13 @@ Config::Config(int argc, char const*argv[])
 	{
 		m_command = "version";		
 	}
+	else if (m_config_values.count(Options::EXTRACT))
+	{
+		m_command = "extract";
+
+		po::notify(m_config_values);
+		validateExtract();
+	}
 	else
 	{
 		// Read config from file if specified
@@ -67,6 +151,11 @@ Config::Config(int argc, char const*argv[])
 
 		po::notify(m_config_values);    
 
+		if (m_config_values.count(Options::FILTER))
+		{
+			m_command = "filter";
+		}
+
 		// Validate parameters
 		validate();
 	}
@@ -152,14 +241,200 @@ string Config::sourceSize() const
 				m_config_values[Options::SRC_SIZE].as<string>() : "";
 }
 
+//-----------------------------------------------------------------------------
+string Config::qualityTier() const
+{
+	return m_config_values[Options::QUALITY_TIER].as<string>();
+}
+
+//-----------------------------------------------------------------------------
+bool Config::isStatsEnabled() const
+{
+	return m_config_values.count(Options::STATS) > 0;
+}
+
+//-----------------------------------------------------------------------------
+bool Config::isPyramidEnabled() const
+{
+	return m_config_values.count(Options::PYRAMID) > 0;
+}
+
+//-----------------------------------------------------------------------------
+string Config::exifOut() const
+{
+	return m_config_values.count(Options::EXIF_OUT) ?
+				m_config_values[Options::EXIF_OUT].as<string>() : "";
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Config::shardLevels() const
+{
+	return m_config_values[Options::SHARD_LEVELS].as<unsigned int>();
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Config::shardDigits() const
+{
+	return m_config_values[Options::SHARD_DIGITS].as<unsigned int>();
+}
+
+//-----------------------------------------------------------------------------
+bool Config::isAutoOrientEnabled() const
+{
+	return m_config_values.count(Options::NO_AUTO_ORIENT) == 0;
+}
+
+//-----------------------------------------------------------------------------
+ResizeOptions Config::resizeOptions() const
+{
+	ResizeOptions options;
+	options.sourceSize(sourceSize());
+	options.qualityTier(qualityTier());
+	options.pyramidEnabled(isPyramidEnabled());
+	options.autoOrientEnabled(isAutoOrientEnabled());
+	options.shardLevels(shardLevels());
+	options.shardDigits(shardDigits());
+	options.metaEnabled(isMetaEnabled());
+	options.contentsEnabled(isContentsEnabled());
+	options.masterCache(masterCache());
+	options.masterSize(masterSize());
+	options.maxPixels(maxPixels());
+	options.decodeTimeout(decodeTimeout());
+
+	return options;
+}
+
+//-----------------------------------------------------------------------------
+string Config::packScope() const
+{
+	return m_config_values.count(Options::PACK) ?
+				m_config_values[Options::PACK].as<string>() : "";
+}
+
+//-----------------------------------------------------------------------------
+string Config::packFile() const
+{
+	return m_config_values[Options::PACK_FILE].as<string>();
+}
+
+//-----------------------------------------------------------------------------
+string Config::extractEntry() const
+{
+	return m_config_values[Options::EXTRACT].as<string>();
+}
+
+//-----------------------------------------------------------------------------
+string Config::traceFile() const
+{
+	return m_config_values.count(Options::TRACE) ?
+				m_config_values[Options::TRACE].as<string>() : "";
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Config::jobs() const
+{
+	return m_config_values[Options::JOBS].as<unsigned int>();
+}
+
+//-----------------------------------------------------------------------------
+bool Config::isAutoThreads() const
+{
+	return m_config_values.count(Options::AUTO_THREADS) > 0;
+}
+
+//-----------------------------------------------------------------------------
+string Config::tuneProfile() const
+{
+	return m_config_values[Options::TUNE_PROFILE].as<string>();
+}
+
+//-----------------------------------------------------------------------------
+bool Config::isRecalibrate() const
+{
+	return m_config_values.count(Options::RECALIBRATE) > 0;
+}
+
+//-----------------------------------------------------------------------------
+bool Config::isNuma() const
+{
+	return m_config_values.count(Options::NUMA) > 0;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Config::prefetchDepth() const
+{
+	return m_config_values[Options::PREFETCH].as<unsigned int>();
+}
+
+//-----------------------------------------------------------------------------
+size_t Config::prefetchBudget() const
+{
+	return (size_t)m_config_values[Options::PREFETCH_BUDGET].as<unsigned int>() * 1024 * 1024;
+}
+
+//-----------------------------------------------------------------------------
+bool Config::isPrefetchBuffer() const
+{
+	return m_config_values.count(Options::PREFETCH_BUFFER) > 0;
+}
+
+//-----------------------------------------------------------------------------
+string Config::masterCache() const
+{
+	return m_config_values.count(Options::MASTER_CACHE) ?
+				m_config_values[Options::MASTER_CACHE].as<string>() : "";
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Config::masterSize() const
+{
+	return m_config_values[Options::MASTER_SIZE].as<unsigned int>();
+}
+
+//-----------------------------------------------------------------------------
+bool Config::isEstimate() const
+{
+	return m_config_values.count(Options::ESTIMATE) > 0;
+}
+
+//-----------------------------------------------------------------------------
+string Config::costProfile() const
+{
+	return m_config_values[Options::COST_PROFILE].as<string>();
+}
+
+//-----------------------------------------------------------------------------
+string Config::schedule() const
+{
+	return m_config_values[Options::SCHEDULE].as<string>();
+}
+
+//-----------------------------------------------------------------------------
+string Config::metricsFile() const
+{
+	return m_config_values.count(Options::METRICS_FILE) ?
+				m_config_values[Options::METRICS_FILE].as<string>() : "";
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Config::metricsInterval() const
+{
+	return m_config_values[Options::METRICS_INTERVAL].as<unsigned int>();
+}
+
 //-----------------------------------------------------------------------------
 void Config::validate()
 {
 	vector<string> required_params;
-	required_params.push_back(Options::SOURCE);
-	required_params.push_back(Options::DEST);
 	required_params.push_back(Options::SIZE);
 
+	// Filter mode reads stdin and writes stdout
+	if (m_command != "filter")
+	{
+		required_params.push_back(Options::SOURCE);
+		required_params.push_back(Options::DEST);
+	}
+
 	// Check for presence of required parameters
 	for (int i = 0; i < required_params.size(); i++)
 	{
@@ -175,11 +450,99 @@ void Config::validate()
 		return;
 	}
 
-	// Check source path
-	if (!fs::exists(source()) || !fs::is_directory(source()))
+	// Check quality tier
+	string tier = qualityTier();
+	if (tier != ImageResizer::QualityTier::DRAFT 
+		&& tier != ImageResizer::QualityTier::NORMAL 
+		&& tier != ImageResizer::QualityTier::HIGH)
+	{
+		m_errors.push_back(string("Unknown quality tier ") + tier);
+	}
+
+	// Check pack scope
+	string scope = packScope();
+	if (!scope.empty() && scope != PackStore::Scope::ALIAS && scope != PackStore::Scope::RUN)
+	{
+		m_errors.push_back(string("Unknown pack scope ") + scope);
+	}
+
+	// Check resampling filters
+	vector<Size> size_list = sizes();
+	for (int i = 0; i < size_list.size(); i++)
+	{
+		string filter = size_list[i].filter();
+		if (!filter.empty() 
+			&& filter != Size::Filter::BOX 
+			&& filter != Size::Filter::TRIANGLE 
+			&& filter != Size::Filter::CATROM 
+			&& filter != Size::Filter::LANCZOS)
+		{
+			m_errors.push_back(string("Unknown filter ") + filter + " in size " + size_list[i].alias());
+		}
+	}
+
+	if (schedule() != Batch::Schedule::NAME && schedule() != Batch::Schedule::LARGEST)
+	{
+		m_errors.push_back(string("Unknown schedule ") + schedule());
+	}
+
+	// Shard names are taken from 16 hex digits of 64-bit hash
+	if (shardLevels() > 0 && (shardDigits() == 0 || shardLevels() * shardDigits() > 16))
+	{
+		m_errors.push_back(string("--") + Options::SHARD_LEVELS + " times --" + Options::SHARD_DIGITS 
+							+ " must be between 1 and 16");
+	}
+
+	if (metricsInterval() == 0)
+	{
+		m_errors.push_back(string("--") + Options::METRICS_INTERVAL + " must be positive");
+	}
+
+	if (masterSize() == 0)
+	{
+		m_errors.push_back(string("--") + Options::MASTER_SIZE + " must be positive");
+	}
+
+	if (maxPixels() < 0)
+	{
+		m_errors.push_back(string("--") + Options::MAX_MEGAPIXELS + " must not be negative");
+	}
+
+	if (m_command == "filter")
+	{
+		return;
+	}
+
+	// Check source path, directory or archive
+	if (!fs::exists(source()) || (!fs::is_directory(source()) && !fs::is_regular_file(source())))
 	{
 		m_errors.push_back(string("Directory ") + source() + " doesn't exists.");
 	}
+	else if (fs::is_regular_file(source()))
+	{
+		try
+		{
+			if (!ArchiveReader::create(source()))
+			{
+				m_errors.push_back(string("Source ") + source() + " is not a directory or tar/zip archive.");
+			}
+		}
+		catch (std::exception &ex)
+		{
+			m_errors.push_back(ex.what());
+		}
+
+		if (isEstimate())
+		{
+			m_errors.push_back(string("--") + Options::ESTIMATE + " needs directory source");
+		}
+	}
+
+	// Dry run does not write anything
+	if (isEstimate())
+	{
+		return;
+	}
 
 	// Check ability to create destinations directory
 
@@ -193,3 +556,43 @@ void Config::validate()
 		m_errors.push_back(string("Can not create directory ") + dest());
 	}
 }
+
+//-----------------------------------------------------------------------------
+void Config::validateExtract()
+{
+	if (!m_config_values.count(Options::PACK_FILE))
+	{
+		m_errors.push_back(string("--") + Options::PACK_FILE + " is required parameter");
+		return;
+	}
+
+	if (!fs::exists(packFile() + Pack::INDEX_EXTENSION))
+	{
+		m_errors.push_back(string("Pack ") + packFile() + " doesn't exists.");
+	}
+}
+
+//-----------------------------------------------------------------------------
+double Config::maxPixels() const
+{
+	return m_config_values[Options::MAX_MEGAPIXELS].as<double>() * 1e6;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Config::decodeTimeout() const
+{
+	return m_config_values[Options::DECODE_TIMEOUT].as<unsigned int>();
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Config::fileTimeout() const
+{
+	return m_config_values[Options::FILE_TIMEOUT].as<unsigned int>();
+}
+
+//-----------------------------------------------------------------------------
+string Config::quarantine() const
+{
+	return m_config_values.count(Options::QUARANTINE) ?
+				m_config_values[Options::QUARANTINE].as<string>() : "";
+}
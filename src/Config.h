@@ -3,6 +3,7 @@
 #define _CONFIG_H
 
 #include "Size.h"
+#include "ResizeOptions.h"
 #include <string>
 #include <vector>
 
@@ -83,12 +84,170 @@ public:
      */
     std::string sourceSize() const;
 
+    /**
+     * Resampling quality tier: draft, normal or high
+     */
+    std::string qualityTier() const;
+
+    /**
+     * Is operation statistics output enabled
+     */
+    bool isStatsEnabled() const;
+
+    /**
+     * File receiving exif info in filter mode, empty if not requested
+     */
+    std::string exifOut() const;
+
+    /**
+     * Levels of hashed output subdirectories, 0 for flat layout
+     */
+    unsigned int shardLevels() const;
+
+    /**
+     * Hex digits per shard level
+     */
+    unsigned int shardDigits() const;
+
+    /**
+     * Is exif orientation applied to results
+     */
+    bool isAutoOrientEnabled() const;
+
+    /**
+     * Is image pyramid used to produce sizes
+     */
+    bool isPyramidEnabled() const;
+
+    /**
+     * Library options built from configuration
+     */
+    ResizeOptions resizeOptions() const;
+
+    /**
+     * Pack scope (alias or run), empty if outputs are written as files
+     */
+    std::string packScope() const;
+
+    /**
+     * Pack to extract entry from, without extension
+     */
+    std::string packFile() const;
+
+    /**
+     * Name of pack entry to extract
+     */
+    std::string extractEntry() const;
+
+    /**
+     * Trace output path, empty if tracing is disabled
+     */
+    std::string traceFile() const;
+
+    /**
+     * Count of files processed in parallel
+     */
+    unsigned int jobs() const;
+
+    /**
+     * Is per-file choice of inner (per-image) threads enabled
+     */
+    bool isAutoThreads() const;
+
+    /**
+     * Path of cached parallelism profile
+     */
+    std::string tuneProfile() const;
+
+    /**
+     * Is parallelism calibration forced
+     */
+    bool isRecalibrate() const;
+
+    /**
+     * Is NUMA aware worker placement enabled
+     */
+    bool isNuma() const;
+
+    /**
+     * Count of files to prefetch ahead, 0 if prefetching is disabled
+     */
+    unsigned int prefetchDepth() const;
+
+    /**
+     * Maximum prefetched and not yet processed bytes
+     */
+    size_t prefetchBudget() const;
+
+    /**
+     * Is prefetching into memory buffers (instead of kernel readahead)
+     */
+    bool isPrefetchBuffer() const;
+
+    /**
+     * Directory of reduced resolution master cache, empty if disabled
+     */
+    std::string masterCache() const;
+
+    /**
+     * Long edge of cached masters in pixels
+     */
+    unsigned int masterSize() const;
+
+    /**
+     * Is dry run estimating batch cost requested
+     */
+    bool isEstimate() const;
+
+    /**
+     * Cached cost model of this host
+     */
+    std::string costProfile() const;
+
+    /**
+     * Queue order of files, name or largest
+     */
+    std::string schedule() const;
+
+    /**
+     * Prometheus textfile for live metrics, empty if disabled
+     */
+    std::string metricsFile() const;
+
+    /**
+     * Seconds between metrics file rewrites
+     */
+    unsigned int metricsInterval() const;
+
+    /**
+     * Limit of pixels declared by file, 0 for none
+     */
+    double maxPixels() const;
+
+    /**
+     * Limit of decode time per file in ms, 0 for none
+     */
+    unsigned int decodeTimeout() const;
+
+    /**
+     * Limit of total processing time per file in ms, 0 for none
+     */
+    unsigned int fileTimeout() const;
+
+    /**
+     * Directory receiving files that exceed limits, empty if disabled
+     */
+    std::string quarantine() const;
+
 private:	
 	Config(const Config &);
 	
 	// Validate parameters
 	void validate();
 
+	// Validate extract command parameters
+	void validateExtract();
+
 private:
 	// Configuration option names
 	class Options
@@ -104,6 +263,37 @@ private:
 		static const char *SRC_SIZE;
 		static const char *META;
 		static const char *CONTENTS;
+		static const char *QUALITY_TIER;
+		static const char *STATS;
+		static const char *PYRAMID;
+		static const char *NO_AUTO_ORIENT;
+		static const char *SHARD_LEVELS;
+		static const char *SHARD_DIGITS;
+		static const char *PACK;
+		static const char *PACK_FILE;
+		static const char *EXTRACT;
+		static const char *FILTER;
+		static const char *EXIF_OUT;
+		static const char *TRACE;
+		static const char *JOBS;
+		static const char *AUTO_THREADS;
+		static const char *TUNE_PROFILE;
+		static const char *RECALIBRATE;
+		static const char *NUMA;
+		static const char *PREFETCH;
+		static const char *PREFETCH_BUDGET;
+		static const char *PREFETCH_BUFFER;
+		static const char *MASTER_CACHE;
+		static const char *MASTER_SIZE;
+		static const char *ESTIMATE;
+		static const char *COST_PROFILE;
+		static const char *SCHEDULE;
+		static const char *METRICS_FILE;
+		static const char *METRICS_INTERVAL;
+		static const char *MAX_MEGAPIXELS;
+		static const char *DECODE_TIMEOUT;
+		static const char *FILE_TIMEOUT;
+		static const char *QUARANTINE;
 	};
 
 	// Command
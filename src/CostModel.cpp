@@ -0,0 +1,265 @@
+#include "CostModel.h"
+#include "ImageResizer.h"
+#include "Stats.h"
+
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include <Magick++.h>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+
+// Model file version, bump when keys change
+static const unsigned int VERSION = 1;
+
+// Benchmark image dimensions, 3 megapixels
+static const unsigned int BENCH_WIDTH = 2048;
+static const unsigned int BENCH_HEIGHT = 1536;
+
+// Benchmark runs, best one is used
+static const int BENCH_RUNS = 3;
+
+// Formats calibrated by benchmark
+static const char *FORMATS[] = { "JPEG", "PNG" };
+
+// Required coefficients
+static const char *KEYS[] = { 
+	"decode.JPEG", "decode.PNG", "encode.JPEG", "encode.PNG", "bytes.JPEG", "bytes.PNG", 
+	"resample.draft", "resample.normal", "resample.high", "memory" 
+};
+
+
+//-----------------------------------------------------------------------------
+CostModel::CostModel()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+CostModel::~CostModel()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+bool CostModel::load(const string &path)
+{
+	ifstream ins(path.c_str());
+
+	string key;
+	unsigned int version = 0;
+	if (!(ins >> key >> version) || key != "version" || version != VERSION)
+	{
+		return false;
+	}
+
+	map<string, double> coefficients;
+	double value;
+	while (ins >> key >> value)
+	{
+		coefficients[key] = value;
+	}
+
+	for (int i = 0; i < sizeof(KEYS) / sizeof(KEYS[0]); ++i)
+	{
+		if (coefficients.find(KEYS[i]) == coefficients.end())
+		{
+			return false;
+		}
+	}
+
+	m_coefficients = coefficients;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool CostModel::save(const string &path) const
+{
+	fs::path parent = fs::path(path).parent_path();
+	if (!parent.empty())
+	{
+		fs::create_directories(parent);
+	}
+
+	ofstream outs(path.c_str(), ios::out | ios::trunc);
+	outs << "version " << VERSION << "\n";
+	outs.precision(9);
+
+	for (map<string, double>::const_iterator it = m_coefficients.begin(); it != m_coefficients.end(); ++it)
+	{
+		outs << it->first << " " << it->second << "\n";
+	}
+
+	outs.flush();
+	return outs.good();
+}
+
+//-----------------------------------------------------------------------------
+void CostModel::calibrate()
+{
+	Stats::Timer timer("cost.calibrate");
+
+	// Costs are per file, files are processed by parallel workers
+	ImageResizer::threads(1);
+
+	// Plasma fractal compresses roughly like a photo, unlike flat color or noise
+	Magick::Image source;
+	source.size(Magick::Geometry(BENCH_WIDTH, BENCH_HEIGHT));
+	source.read("plasma:fractal");
+
+	double pixels = (double)BENCH_WIDTH * BENCH_HEIGHT;
+
+	Magick::Geometry target(BENCH_WIDTH / 4, BENCH_HEIGHT / 4);
+	target.aspect(true);
+
+	m_coefficients.clear();
+	for (int i = 0; i < sizeof(FORMATS) / sizeof(FORMATS[0]); ++i)
+	{
+		string format = FORMATS[i];
+
+		double encode = 0;
+		double decode = 0;
+		Magick::Blob blob;
+
+		for (int run = 0; run < BENCH_RUNS; ++run)
+		{
+			Magick::Image image(source);
+
+			double start = Stats::now();
+			image.write(&blob, format);
+			double encoded = Stats::now();
+
+			Magick::Image decoded(blob);
+			double end = Stats::now();
+
+			if (run == 0 || encoded - start < encode)
+			{
+				encode = encoded - start;
+			}
+
+			if (run == 0 || end - encoded < decode)
+			{
+				decode = end - encoded;
+			}
+		}
+
+		m_coefficients["encode." + format] = encode / pixels;
+		m_coefficients["decode." + format] = decode / pixels;
+		m_coefficients["bytes." + format] = blob.length() / pixels;
+	}
+
+	// Same operations as resizer uses for each tier
+	double draft = 0;
+	double normal = 0;
+	double high = 0;
+
+	for (int run = 0; run < BENCH_RUNS; ++run)
+	{
+		Magick::Image image(source);
+		Magick::Geometry twice(target.width() * 2, target.height() * 2);
+		twice.aspect(true);
+
+		double start = Stats::now();
+		image.sample(twice);
+		image.scale(target);
+		double spent = Stats::now() - start;
+		draft = (run == 0) ? spent : min(draft, spent);
+
+		image = source;
+		start = Stats::now();
+		image.scale(target);
+		spent = Stats::now() - start;
+		normal = (run == 0) ? spent : min(normal, spent);
+
+		image = source;
+		start = Stats::now();
+		image.filterType(Magick::LanczosFilter);
+		image.resize(target);
+		spent = Stats::now() - start;
+		high = (run == 0) ? spent : min(high, spent);
+	}
+
+	m_coefficients["resample." + ImageResizer::QualityTier::DRAFT] = draft / pixels;
+	m_coefficients["resample." + ImageResizer::QualityTier::NORMAL] = normal / pixels;
+	m_coefficients["resample." + ImageResizer::QualityTier::HIGH] = high / pixels;
+
+	// Decoded image is stored as pixel packets
+	m_coefficients["memory"] = sizeof(Magick::PixelPacket);
+
+	ImageResizer::threads(0);
+}
+
+//-----------------------------------------------------------------------------
+double CostModel::decodeMs(const string &format, double pixels) const
+{
+	return coefficient("decode", format) * pixels;
+}
+
+//-----------------------------------------------------------------------------
+double CostModel::resampleMs(const string &tier, double pixels) const
+{
+	string key = "resample." + tier;
+	if (m_coefficients.find(key) == m_coefficients.end())
+	{
+		key = "resample." + ImageResizer::QualityTier::HIGH;
+	}
+
+	return value(key) * pixels;
+}
+
+//-----------------------------------------------------------------------------
+double CostModel::encodeMs(const string &format, double pixels) const
+{
+	return coefficient("encode", format) * pixels;
+}
+
+//-----------------------------------------------------------------------------
+double CostModel::encodedBytes(const string &format, double pixels) const
+{
+	return coefficient("bytes", format) * pixels;
+}
+
+//-----------------------------------------------------------------------------
+double CostModel::memoryBytes(double pixels) const
+{
+	return value("memory") * pixels;
+}
+
+//-----------------------------------------------------------------------------
+string CostModel::defaultProfilePath()
+{
+	char host[256] = { 0 };
+	gethostname(host, sizeof(host) - 1);
+
+	const char *home = getenv("HOME");
+	fs::path dir = fs::path(home ? home : ".") / ".phresizer";
+
+	return (dir / (string("cost-") + host)).native();
+}
+
+//-----------------------------------------------------------------------------
+double CostModel::coefficient(const string &stage, const string &format) const
+{
+	string key = stage + "." + format;
+	if (m_coefficients.find(key) == m_coefficients.end())
+	{
+		key = stage + ".PNG";
+	}
+
+	return value(key);
+}
+
+//-----------------------------------------------------------------------------
+double CostModel::value(const string &key) const
+{
+	map<string, double>::const_iterator it = m_coefficients.find(key);
+	return it == m_coefficients.end() ? 0 : it->second;
+}
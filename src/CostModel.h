@@ -0,0 +1,89 @@
+#ifndef _COST_MODEL_H
+#define _COST_MODEL_H 
+
+#include <string>
+#include <map>
+
+/**
+ * Per-host cost model of pipeline stages used to estimate batches 
+ * without decoding pixels. Stage costs are linear in pixel count:
+ * decode and encode per format, resampling per quality tier, 
+ * encoded bytes per output pixel and memory per decoded pixel.
+ *
+ * Coefficients come from a short single-threaded benchmark on 
+ * a synthetic image and are cached in a file like parallelism profile.
+ */
+class CostModel
+{
+public:
+	/**
+	 * Create empty model, calibrate or load before use
+	 */
+	CostModel();
+
+	/**
+	 * Destructor
+	 */
+	virtual ~CostModel();
+
+public:
+	/**
+	 * Load cached model
+	 * @return false if file is missing or incomplete.
+	 */
+	bool load(const std::string &path);
+
+	/**
+	 * Save model
+	 */
+	bool save(const std::string &path) const;
+
+	/**
+	 * Run benchmark and fill coefficients
+	 */
+	void calibrate();
+
+	/**
+	 * Time in ms to decode image of specified format
+	 */
+	double decodeMs(const std::string &format, double pixels) const;
+
+	/**
+	 * Time in ms to resample image with quality tier, filtered 
+	 * resizes cost as high tier
+	 */
+	double resampleMs(const std::string &tier, double pixels) const;
+
+	/**
+	 * Time in ms to encode image of specified format
+	 */
+	double encodeMs(const std::string &format, double pixels) const;
+
+	/**
+	 * Encoded size in bytes of image of specified format
+	 */
+	double encodedBytes(const std::string &format, double pixels) const;
+
+	/**
+	 * Memory in bytes held by decoded image
+	 */
+	double memoryBytes(double pixels) const;
+
+	/**
+	 * Default model path for this host: $HOME/.phresizer/cost-<hostname>
+	 */
+	static std::string defaultProfilePath();
+
+private:
+	// Coefficient of format specific stage, formats not calibrated use PNG (lossless) one
+	double coefficient(const std::string &stage, const std::string &format) const;
+
+	// Coefficient by key, 0 if missing
+	double value(const std::string &key) const;
+
+private:
+	// Key ("decode.JPEG", "resample.normal", ...) -> cost per pixel
+	std::map<std::string, double> m_coefficients;
+};
+
+#endif
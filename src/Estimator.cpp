@@ -0,0 +1,219 @@
+#include "Estimator.h"
+#include "ImageResizer.h"
+#include "ResizePlan.h"
+#include "Batch.h"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include <boost/thread/thread.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+
+//-----------------------------------------------------------------------------
+Estimator::Estimator(const Config &conf)
+	:m_conf(conf)
+{
+	string profile = conf.costProfile();
+	if (conf.isRecalibrate() || !m_model.load(profile))
+	{
+		if (conf.isVerbose())
+		{
+			cout << "Calibrating cost model\n";
+		}
+
+		m_model.calibrate();
+		m_model.save(profile);
+	}
+}
+
+//-----------------------------------------------------------------------------
+Estimator::~Estimator()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Estimator::FileCost::FileCost()
+	:ms(0)
+	,memory(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+void Estimator::run(const vector<fs::path> &files, ostream &outs)
+{
+	m_bytes.clear();
+
+	vector<FileCost> costs;
+	vector<pair<unsigned int, unsigned int> > dims;
+	double pixels = 0;
+	double cpu = 0;
+	size_t skipped = 0;
+
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		string file = fs::absolute(files[i]).native();
+		if (!fs::is_regular_file(file))
+		{
+			continue;
+		}
+
+		unsigned int width = 0;
+		unsigned int height = 0;
+		string format;
+		if (!ImageResizer::ping(file, width, height, format))
+		{
+			skipped++;
+			continue;
+		}
+
+		FileCost cost = estimate(width, height, format);
+
+		costs.push_back(cost);
+		dims.push_back(make_pair(width, height));
+		pixels += (double)width * height;
+		cpu += cost.ms;
+	}
+
+	// Same queue order as Batch::schedule, unreadable files are last there and do not count
+	if (m_conf.schedule() == Batch::Schedule::LARGEST)
+	{
+		vector<size_t> order = Batch::largestFirst(dims, m_conf.sizes().size());
+
+		vector<FileCost> ordered;
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			ordered.push_back(costs[order[i]]);
+		}
+
+		costs.swap(ordered);
+	}
+
+	unsigned int jobs = m_conf.jobs();
+	unsigned int cores = max(1u, boost::thread::hardware_concurrency());
+
+	// More jobs than cores share them
+	double wall = makespan(costs, jobs) * max(1.0, (double)jobs / cores);
+
+	// Worst case: the largest files are in flight at the same time
+	vector<double> memory;
+	for (size_t i = 0; i < costs.size(); ++i)
+	{
+		memory.push_back(costs[i].memory);
+	}
+
+	sort(memory.begin(), memory.end(), greater<double>());
+
+	double peak = 0;
+	for (size_t i = 0; i < memory.size() && i < jobs; ++i)
+	{
+		peak += memory[i];
+	}
+
+	if (m_conf.prefetchDepth() > 0 && m_conf.isPrefetchBuffer())
+	{
+		peak += m_conf.prefetchBudget();
+	}
+
+	double total = 0;
+
+	outs << "Estimate:\n" << fixed << setprecision(1);
+	outs << "files: " << costs.size() << " (" << skipped << " unreadable)\n";
+	outs << "source: " << pixels / 1e6 << " MP\n";
+	outs << "cpu time: " << cpu / 1000.0 << " s\n";
+	outs << "wall time: " << wall / 1000.0 << " s at " << jobs << " jobs, " << m_conf.schedule() << " schedule\n";
+	outs << "peak memory: " << peak / 1048576.0 << " MB\n";
+
+	for (int i = 0; i < m_conf.sizes().size(); ++i)
+	{
+		string alias = m_conf.sizes()[i].alias();
+		outs << "output " << alias << ": " << m_bytes[alias] / 1048576.0 << " MB\n";
+		total += m_bytes[alias];
+	}
+
+	outs << "output total: " << total / 1048576.0 << " MB\n";
+}
+
+//-----------------------------------------------------------------------------
+Estimator::FileCost Estimator::estimate(unsigned int width, unsigned int height, const string &format)
+{
+	FileCost cost;
+
+	double source = (double)width * height;
+	double largest = 0;
+
+	cost.ms = m_model.decodeMs(format, source);
+
+	vector<Size> sizes = m_conf.sizes();
+	unsigned int prev_width = width;
+	unsigned int prev_height = height;
+
+	for (int i = 0; i < sizes.size(); ++i)
+	{
+		const Size &size = sizes[i];
+
+		unsigned int in_width = size.usePrevious() ? prev_width : width;
+		unsigned int in_height = size.usePrevious() ? prev_height : height;
+
+		ResizePlan plan(in_width, in_height, size);
+		if (!plan.isValid())
+		{
+			continue;
+		}
+
+		double input = (double)in_width * in_height;
+		double scaled = (double)plan.scaleWidth() * plan.scaleHeight();
+		double output = (double)plan.width() * plan.height();
+
+		if (plan.scaleWidth() != in_width || plan.scaleHeight() != in_height)
+		{
+			string tier = size.filter().empty() ? m_conf.qualityTier() : ImageResizer::QualityTier::HIGH;
+			cost.ms += m_model.resampleMs(tier, input);
+		}
+
+		cost.ms += m_model.encodeMs(format, output);
+		m_bytes[size.alias()] += m_model.encodedBytes(format, output);
+
+		largest = max(largest, scaled + output);
+
+		prev_width = plan.width();
+		prev_height = plan.height();
+	}
+
+	// Source and pyramid levels stay alive while sizes are produced
+	double held = m_conf.isPyramidEnabled() ? source * 4 / 3 : source;
+	cost.memory = m_model.memoryBytes(held + largest);
+
+	return cost;
+}
+
+//-----------------------------------------------------------------------------
+double Estimator::makespan(const vector<FileCost> &costs, unsigned int jobs) const
+{
+	// Finish times of busy workers, the earliest on top
+	priority_queue<double, vector<double>, greater<double> > workers;
+	for (unsigned int i = 0; i < max(1u, jobs); ++i)
+	{
+		workers.push(0);
+	}
+
+	double end = 0;
+	for (size_t i = 0; i < costs.size(); ++i)
+	{
+		double finish = workers.top() + costs[i].ms;
+		workers.pop();
+		workers.push(finish);
+
+		end = max(end, finish);
+	}
+
+	return end;
+}
@@ -0,0 +1,75 @@
+
+#ifndef _ESTIMATOR_H
+#define _ESTIMATOR_H 
+
+#include "Config.h"
+#include "CostModel.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+
+#include <boost/filesystem.hpp>
+
+/**
+ * Dry run of batch (--estimate). Files are only pinged for dimensions 
+ * and format, sizes are planned as resizer would plan them and stage 
+ * costs come from host CostModel. Predicts wall time at configured 
+ * job count, peak memory and output bytes per alias.
+ *
+ * Per file costs are single-threaded, so estimate is pessimistic for 
+ * one job using multi-threaded GraphicsMagick.
+ */
+class Estimator
+{
+public:
+	/**
+	 * Create estimator, loads or calibrates cost model
+	 */
+	Estimator(const Config &conf);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~Estimator();
+
+public:
+	/**
+	 * Estimate processing of files and print report
+	 */
+	void run(const std::vector<boost::filesystem::path> &files, std::ostream &outs);
+
+private:
+	Estimator(const Estimator &);
+
+	// Estimated cost of one file
+	struct FileCost
+	{
+		FileCost();
+
+		// Processing time in milliseconds
+		double ms;
+
+		// Peak memory in bytes
+		double memory;
+	};
+
+	// Estimate one file, adds its outputs to per alias bytes
+	FileCost estimate(unsigned int width, unsigned int height, const std::string &format);
+
+	// Wall time of processing costs in queue order by workers taking next file when free
+	double makespan(const std::vector<FileCost> &costs, unsigned int jobs) const;
+
+private:
+	// Configuration
+	const Config &m_conf;
+
+	// Host cost model
+	CostModel m_model;
+
+	// Alias -> estimated output bytes
+	std::map<std::string, double> m_bytes;
+};
+
+#endif
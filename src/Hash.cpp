@@ -0,0 +1,28 @@
+#include "Hash.h"
+
+#include <cstdio>
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+uint64_t Hash::fnv1a(const string &data)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+//-----------------------------------------------------------------------------
+string Hash::hex(uint64_t value)
+{
+	char digits[17];
+	snprintf(digits, sizeof(digits), "%016llx", (unsigned long long)value);
+
+	return digits;
+}
@@ -0,0 +1,27 @@
+#ifndef _HASH_H
+#define _HASH_H 
+
+#include <string>
+
+#include <stdint.h>
+
+/**
+ * Hash with fixed specification, for names persisted on disk 
+ * (output shards, cache keys). Unlike std or boost hashes its 
+ * values never change between library versions or platforms.
+ */
+class Hash
+{
+public:
+	/**
+	 * 64-bit FNV-1a of data
+	 */
+	static uint64_t fnv1a(const std::string &data);
+
+	/**
+	 * 16 lowercase hex digits of value
+	 */
+	static std::string hex(uint64_t value);
+};
+
+#endif
@@ -0,0 +1,110 @@
+#include "ImagePyramid.h"
+#include "Stats.h"
+
+using namespace std;
+
+
+// Accumulator wide enough to hold sum of four quantums
+#if QuantumDepth > 16
+typedef magick_uint64_t Accumulator;
+#else
+typedef unsigned int Accumulator;
+#endif
+
+
+//-----------------------------------------------------------------------------
+ImagePyramid::ImagePyramid(const Magick::Image &source)
+{
+	m_levels.push_back(source);
+}
+
+//-----------------------------------------------------------------------------
+ImagePyramid::~ImagePyramid()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+const Magick::Image &ImagePyramid::level(unsigned int width, unsigned int height)
+{
+	unsigned int index = 0;
+
+	while (true)
+	{
+		const Magick::Image &current = m_levels[index];
+
+		// Next level would be too small (or degenerate)
+		if (current.columns() / 2 < width || current.rows() / 2 < height
+			|| current.columns() < 2 || current.rows() < 2)
+		{
+			break;
+		}
+
+		if (index + 1 == m_levels.size())
+		{
+			Stats::Timer timer("pyramid.halve", (double)current.columns() * current.rows());
+			m_levels.push_back(halve(current));
+		}
+
+		++index;
+	}
+
+	return m_levels[index];
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ImagePyramid::levels() const
+{
+	return m_levels.size();
+}
+
+//-----------------------------------------------------------------------------
+double ImagePyramid::bytes() const
+{
+	double result = 0;
+	for (unsigned int i = 1; i < m_levels.size(); ++i)
+	{
+		result += (double)m_levels[i].columns() * m_levels[i].rows() * sizeof(Magick::PixelPacket);
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+Magick::Image ImagePyramid::halve(const Magick::Image &image)
+{
+	unsigned int width = image.columns() / 2;
+	unsigned int height = image.rows() / 2;
+
+	Magick::Image result(Magick::Geometry(width, height), Magick::Color("black"));
+	result.matte(image.matte());
+	result.quality(image.quality());
+	result.magick(image.magick());
+	result.modifyImage();
+
+	for (unsigned int y = 0; y < height; ++y)
+	{
+		// Two source rows are returned as one contiguous block
+		const Magick::PixelPacket *top = image.getConstPixels(0, y * 2, width * 2, 2);
+		const Magick::PixelPacket *bottom = top + width * 2;
+		Magick::PixelPacket *out = result.setPixels(0, y, width, 1);
+
+		// Plain loop over independent pixels, lets compiler vectorize it
+		for (unsigned int x = 0; x < width; ++x)
+		{
+			const Magick::PixelPacket &a = top[x * 2];
+			const Magick::PixelPacket &b = top[x * 2 + 1];
+			const Magick::PixelPacket &c = bottom[x * 2];
+			const Magick::PixelPacket &d = bottom[x * 2 + 1];
+
+			out[x].red = (Magick::Quantum)(((Accumulator)a.red + b.red + c.red + d.red + 2) >> 2);
+			out[x].green = (Magick::Quantum)(((Accumulator)a.green + b.green + c.green + d.green + 2) >> 2);
+			out[x].blue = (Magick::Quantum)(((Accumulator)a.blue + b.blue + c.blue + d.blue + 2) >> 2);
+			out[x].opacity = (Magick::Quantum)(((Accumulator)a.opacity + b.opacity + c.opacity + d.opacity + 2) >> 2);
+		}
+
+		result.syncPixels();
+	}
+
+	return result;
+}
@@ -0,0 +1,53 @@
+
+#ifndef _IMAGE_PYRAMID_H
+#define _IMAGE_PYRAMID_H 
+
+#include <vector>
+
+#include <Magick++.h>
+
+/**
+ * Image pyramid (mipmap) built from source by successive 2x2 box reductions.
+ * Levels are built lazily, only as deep as requested sizes need.
+ */
+class ImagePyramid
+{
+public:
+	/**
+	 * Create pyramid with source image as level 0
+	 */
+	ImagePyramid(const Magick::Image &source);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~ImagePyramid();
+
+public:
+	/**
+	 * Get the smallest level which is still at least width x height. 
+	 * Returns source if no reduced level is large enough.
+	 */
+	const Magick::Image &level(unsigned int width, unsigned int height);
+
+	/**
+	 * Count of built levels including source
+	 */
+	unsigned int levels() const;
+
+	/**
+	 * Pixel memory of built reduced levels in bytes, source excluded
+	 */
+	double bytes() const;
+
+	/**
+	 * Reduce image to half of its size averaging 2x2 pixel blocks
+	 */
+	static Magick::Image halve(const Magick::Image &image);
+
+private:
+	// Levels, source first
+	std::vector<Magick::Image> m_levels;
+};
+
+#endif
@@ -1,22 +1,48 @@
-
 #include "ImageResizer.h"
 #include "ImageResizerMagick.h"
 
 
 using namespace std;
 
+
+const std::string ImageResizer::QualityTier::DRAFT = "draft";
+const std::string ImageResizer::QualityTier::NORMAL = "normal";
+const std::string ImageResizer::QualityTier::HIGH = "high";
+
+
+//-----------------------------------------------------------------------------
+ImageResizer::AutoPtr ImageResizer::create(const string &file, const ResizeOptions &options)
+{
+	return ImageResizer::AutoPtr(new ImageResizerMagick(file, options));
+}
+
+//-----------------------------------------------------------------------------
+ImageResizer::AutoPtr ImageResizer::create(const void *data, size_t length, const ResizeOptions &options)
+{
+	return ImageResizer::AutoPtr(new ImageResizerMagick(data, length, options));
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizer::ping(const string &file, unsigned int &width, unsigned int &height)
+{
+	string format;
+	return ImageResizerMagick::ping(file, width, height, format);
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizer::ping(const string &file, unsigned int &width, unsigned int &height, string &format)
+{
+	return ImageResizerMagick::ping(file, width, height, format);
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizer::ping(const void *data, size_t length, unsigned int &width, unsigned int &height)
+{
+	return ImageResizerMagick::ping(data, length, width, height);
+}
+
 //-----------------------------------------------------------------------------
-ImageResizer::AutoPtr ImageResizer::create(const string &file, const Config &conf)
+void ImageResizer::threads(unsigned int count)
 {
-	ImageResizer *resizer;
-	if (conf.sourceSize().empty())
-	{
-		resizer = new ImageResizerMagick(file);
-	}
-	else
-	{
-		resizer = new ImageResizerMagick(file, conf.sourceSize());
-	}
-
-	return ImageResizer::AutoPtr(resizer);
+	ImageResizerMagick::threads(count);
 }
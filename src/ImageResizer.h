@@ -3,9 +3,10 @@
 #define _IMAGE_RESIZER_H 
 
 #include "Size.h"
-#include "Config.h"
+#include "ResizeOptions.h"
 
 #include <string>
+#include <cstddef>
 
 #include <boost/smart_ptr.hpp>
 
@@ -13,6 +14,8 @@
 /**
  * Interface for image resizers. 
  * Image resizer is responsible for resizng image to multiple sizes.
+ * Instance is bound to one source image and must not be shared between 
+ * threads, distinct instances can be used concurrently.
  */
 class ImageResizer
 {
@@ -20,9 +23,61 @@ public:
 	typedef boost::shared_ptr<ImageResizer> AutoPtr;
 
 	/**
-	 * Create implementation instance	 
+	 * Resampling quality tier used for sizes without explicit filter
 	 */
-	static AutoPtr create(const std::string &file, const Config &conf);
+	class QualityTier
+	{
+	public:
+		// Point sampling followed by box averaging. Fastest.
+		static const std::string DRAFT;
+
+		// Box averaging scale.
+		static const std::string NORMAL;
+
+		// Lanczos filtered resize. Slowest.
+		static const std::string HIGH;
+	};
+
+	/**
+	 * Create implementation instance reading image from file
+	 */
+	static AutoPtr create(const std::string &file, const ResizeOptions &options);
+
+	/**
+	 * Create implementation instance reading encoded image from memory
+	 * @param data Encoded image.
+	 * @param length Length of data in bytes.
+	 */
+	static AutoPtr create(const void *data, size_t length, const ResizeOptions &options);
+
+	/**
+	 * Read image dimensions from file header without decoding pixels
+	 * @return false if file can not be read.
+	 */
+	static bool ping(const std::string &file, unsigned int &width, unsigned int &height);
+
+	/**
+	 * Read image dimensions and encoding format from file header
+	 * @return false if file can not be read.
+	 */
+	static bool ping(const std::string &file, unsigned int &width, unsigned int &height, std::string &format);
+
+	/**
+	 * Read image dimensions from header of encoded image in memory
+	 * @return false if data is not readable image.
+	 */
+	static bool ping(const void *data, size_t length, unsigned int &width, unsigned int &height);
+
+	/**
+	 * Limit threads used inside one image operation (decode, resample, 
+	 * encode) started from the calling thread. 0 restores default.
+	 */
+	static void threads(unsigned int count);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~ImageResizer() {}
 
 	/**
 	 * Resize operation
@@ -31,6 +86,36 @@ public:
 	 */
 	virtual bool resize(const std::string &dest, const Size &size) = 0;
 
+	/**
+	 * Resize operation encoding result to memory in source format
+	 * @param blob Encoded result.
+	 * @param size Resizing parameters.
+	 */
+	virtual bool resizeToBlob(std::string &blob, const Size &size) = 0;
+
+	/**
+	 * Encoding format of source (and of blob results), e.g. "JPEG"
+	 */
+	virtual std::string format() const = 0;
+
+	/**
+	 * Dimensions of original source
+	 */
+	virtual unsigned int width() const = 0;
+	virtual unsigned int height() const = 0;
+
+	/**
+	 * Check that image in hand has enough resolution to produce size 
+	 * exactly as from the original, false if resizer was opened from 
+	 * too small cached master
+	 */
+	virtual bool covers(const Size &size) const = 0;
+
+	/**
+	 * Get exif info as "name=value" lines
+	 */
+	virtual std::string exif() = 0;
+
 	/**
 	 * Writes exif info to specified file
 	 */
@@ -1,5 +1,10 @@
 
 #include "ImageResizerMagick.h"
+#include "Limits.h"
+#include "MagickExceptionInfo.h"
+#include "MasterCache.h"
+#include "Stats.h"
+#include "Trace.h"
 
 #include <fstream>
 
@@ -7,6 +12,10 @@
 
 #include <boost/algorithm/string.hpp>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace std;
 
 namespace alg = boost::algorithm;
@@ -19,94 +28,454 @@ public:
 	GraphicsMagickInitializer()
 	{
 		Magick::InitializeMagick(NULL);
+		Limits::install();
 	}
 
 	~GraphicsMagickInitializer() {}
 };
 
-// Initilize GM
-static GraphicsMagickInitializer gm_init;
+// Initilize GM once, on first use (function local statics are thread safe)
+static void initializeMagick()
+{
+	static GraphicsMagickInitializer gm_init;
+}
+
+// Pixel memory of image in bytes
+static double pixelBytes(unsigned long columns, unsigned long rows)
+{
+	return (double)columns * rows * sizeof(Magick::PixelPacket);
+}
 
 
 //-----------------------------------------------------------------------------
-ImageResizerMagick::ImageResizerMagick(const string &source)
-	:m_source(source)
+ImageResizerMagick::ImageResizerMagick(const string &source, const ResizeOptions &options)
+	:m_width(0)
+	,m_height(0)
+	,m_orientation(Magick::TopLeftOrientation)
+	,m_oriented(true)
+	,m_master(false)
+	,m_shared(true)
+	,m_peak_bytes(0)
+	,m_tier(options.qualityTier())
 {
-	m_prev = m_source;
+	initializeMagick();
+
+	boost::scoped_ptr<MasterCache> cache;
+	if (!options.masterCache().empty())
+	{
+		cache.reset(new MasterCache(options.masterCache(), options.masterSize(), options.sourceSize()));
+
+		MasterCache::Info info;
+		if (cache->load(source, m_source, info))
+		{
+			m_master = true;
+			m_width = info.width;
+			m_height = info.height;
+			m_format = info.format;
+			m_orientation = (Magick::OrientationType)info.orientation;
+			m_exif = info.exif;
+
+			init(options);
+			return;
+		}
+	}
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+	string format;
+
+	// Refuse decompression bombs before allocating pixels
+	if (options.maxPixels() > 0 && ping(source, width, height, format))
+	{
+		Limits::pixels(width, height, options.maxPixels());
+	}
+
+	{
+		Limits::Deadline deadline("decode", options.decodeTimeout());
+
+		try
+		{
+			if (options.sourceSize().empty())
+			{
+				m_source.read(source);
+			}
+			else
+			{
+				m_source.read(Magick::Geometry(options.sourceSize()), source);
+			}
+		}
+		catch (Magick::Exception &)
+		{
+			// Decode cancelled by progress monitor is reported as limit
+			Limits::check();
+			throw;
+		}
+
+		Limits::check();
+	}
+
+	init(options);
+
+	if (cache)
+	{
+		MasterCache::Info info;
+		info.width = m_width;
+		info.height = m_height;
+		info.format = m_format;
+		info.orientation = m_orientation;
+		info.exif = sourceExif();
+
+		cache->store(source, m_source, info);
+	}
 }
 
 //-----------------------------------------------------------------------------
-ImageResizerMagick::ImageResizerMagick(const string &source, const string &size)
-	:m_source(size, source)
+ImageResizerMagick::ImageResizerMagick(const void *data, size_t length, const ResizeOptions &options)
+	:m_width(0)
+	,m_height(0)
+	,m_orientation(Magick::TopLeftOrientation)
+	,m_oriented(true)
+	,m_master(false)
+	,m_shared(true)
+	,m_peak_bytes(0)
+	,m_tier(options.qualityTier())
 {
-	m_prev = m_source;
+	initializeMagick();
+
+	unsigned int width = 0;
+	unsigned int height = 0;
+
+	// Refuse decompression bombs before allocating pixels
+	if (options.maxPixels() > 0 && ping(data, length, width, height))
+	{
+		Limits::pixels(width, height, options.maxPixels());
+	}
+
+	Magick::Blob blob(data, length);
+	{
+		Limits::Deadline deadline("decode", options.decodeTimeout());
+
+		try
+		{
+			if (options.sourceSize().empty())
+			{
+				m_source.read(blob);
+			}
+			else
+			{
+				m_source.read(blob, Magick::Geometry(options.sourceSize()));
+			}
+		}
+		catch (Magick::Exception &)
+		{
+			// Decode cancelled by progress monitor is reported as limit
+			Limits::check();
+			throw;
+		}
+
+		Limits::check();
+	}
+
+	init(options);
 }
 
 //-----------------------------------------------------------------------------
 ImageResizerMagick::~ImageResizerMagick()
 {
+	Stats::instance().peak("memory.file.mb", m_peak_bytes / 1048576.0);
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::ping(const string &file, unsigned int &width, unsigned int &height, string &format)
+{
+	initializeMagick();
+
+	try
+	{
+		Magick::Image image;
+		image.ping(file);
+
+		width = image.columns();
+		height = image.rows();
+		format = image.magick();
+
+		return true;
+	}
+	catch (std::exception &)
+	{
+		return false;
+	}
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::ping(const void *data, size_t length, unsigned int &width, unsigned int &height)
+{
+	initializeMagick();
+
+	try
+	{
+		Magick::Image image;
+		image.ping(Magick::Blob(data, length));
 
+		width = image.columns();
+		height = image.rows();
+
+		return true;
+	}
+	catch (std::exception &)
+	{
+		return false;
+	}
+}
+
+//-----------------------------------------------------------------------------
+void ImageResizerMagick::threads(unsigned int count)
+{
+#ifdef _OPENMP
+	// Thread count of parallel regions is per calling thread in OpenMP, 
+	// so every worker can run its image with its own limit
+	omp_set_num_threads(count ? count : omp_get_num_procs());
+#endif
 }
 
 //-----------------------------------------------------------------------------
 bool ImageResizerMagick::resize(const std::string &dest, const Size &size)
 {
+	try
+	{
+		if (!apply(size))
+		{
+			return false;
+		}
+
+		Trace::Span span("encode", "io");
+		span.arg("path", dest);
+
+		m_prev.write(dest);
+	}
+	catch (Magick::Exception &)
+	{
+		// Operation cancelled by progress monitor is reported as limit
+		Limits::check();
+		throw;
+	}
+
+	Limits::check();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::resizeToBlob(std::string &blob, const Size &size)
+{
+	try
+	{
+		if (!apply(size))
+		{
+			return false;
+		}
+
+		Trace::Span span("encode", "io");
+		span.arg("format", m_format);
+
+		Magick::Blob encoded;
+		m_prev.write(&encoded, m_format);
+
+		blob.assign((const char *)encoded.data(), encoded.length());
+	}
+	catch (Magick::Exception &)
+	{
+		// Operation cancelled by progress monitor is reported as limit
+		Limits::check();
+		throw;
+	}
+
+	Limits::check();
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+string ImageResizerMagick::format() const
+{
+	return m_format;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ImageResizerMagick::width() const
+{
+	return m_width;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ImageResizerMagick::height() const
+{
+	return m_height;
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::covers(const Size &size) const
+{
+	if (!m_master || size.usePrevious())
+	{
+		return true;
+	}
+
+	bool swap = isTransposed();
+	ResizePlan plan(swap ? m_height : m_width, swap ? m_width : m_height, size);
+
+	if (!plan.isValid())
+	{
+		return true;
+	}
+
+	// Master is stored in source frame
+	unsigned int width = swap ? plan.scaleHeight() : plan.scaleWidth();
+	unsigned int height = swap ? plan.scaleWidth() : plan.scaleHeight();
+
+	return width <= m_source.columns() && height <= m_source.rows();
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::apply(const Size &size)
+{
+	Trace::Span span("resize", "cpu");
+	span.arg("alias", size.alias());
+	span.arg("mode", size.mode());
+
 	if (!size.usePrevious())
 	{
+		// Reference only, source pixels are read by operations and never modified
 		m_prev = m_source;
+		m_shared = true;
+		m_oriented = m_orientation <= Magick::TopLeftOrientation;
 	}
 
-	bool result;
-	if (size.mode() == Size::ResizeMode::FIT)
+	// Sizes are planned in display frame, so width and height 
+	// of source are swapped for orientations which transpose it
+	bool swap = !m_oriented && isTransposed();
+
+	// Plan from original dimensions, so results from master match results from original
+	unsigned int width = size.usePrevious() ? m_prev.columns() : m_width;
+	unsigned int height = size.usePrevious() ? m_prev.rows() : m_height;
+
+	ResizePlan plan(swap ? height : width, swap ? width : height, size);
+	if (!plan.isValid())
 	{
-		result = fit(size);
+		return false;
 	}
-	else if (size.mode() == Size::ResizeMode::STRETCH)
+
+	// Start from the smallest pyramid level which is still larger than result
+	if (m_pyramid && !size.usePrevious() && plan.isResampled())
+	{
+		m_prev = m_pyramid->level(swap ? plan.scaleHeight() : plan.scaleWidth(), 
+								swap ? plan.scaleWidth() : plan.scaleHeight());
+		m_shared = true;
+	}
+
+	bool result;
+	if (size.mode() == Size::ResizeMode::FIT || size.mode() == Size::ResizeMode::STRETCH)
 	{
-		result = stretch(size);
+		result = resample(plan, size);
 	}
 	else if (size.mode() == Size::ResizeMode::PAD)
 	{
-		result = pad(size);
+		result = pad(plan, size);
 	}
 	else if (size.mode() == Size::ResizeMode::FILL_CROP)
 	{
-		result = crop(size);
+		result = crop(plan, size);
 	}
 	else 
 	{
 		result = false;
 	}
 
-	if (result)
+	if (result && m_shared)
 	{
+		Trace::Span strip_span("strip", "cpu");
+
+		// Result is the source itself (same size, no crop or orientation), 
+		// so stripping copies it, at destination size
+		Stats::Timer timer("copy.strip", (double)m_prev.columns() * m_prev.rows());
+		m_peak_bytes = max(m_peak_bytes, heldBytes() + pixelBytes(m_prev.columns(), m_prev.rows()));
+
+		m_prev.strip();
+		m_shared = false;
+	}
+	else if (result)
+	{
+		Trace::Span strip_span("strip", "cpu");
 		m_prev.strip();
-		m_prev.write(dest);
 	}
 
 	return result;
 }
 
 //-----------------------------------------------------------------------------
-bool ImageResizerMagick::writeExif(const std::string &dest)
+string ImageResizerMagick::exif()
 {
-	try 
+	// Results are rotated to display orientation when auto-orient is applied,
+	// so exif must not ask viewers to rotate them again
+	if (m_orientation <= Magick::TopLeftOrientation)
 	{
-		ofstream outs(dest.c_str(), ios::out);
+		return sourceExif();
+	}
 
-		string exif = m_source.attribute("EXIF:*");
+	vector<string> exifValues;
+	string exif = sourceExif();
+	alg::split(exifValues, exif, alg::is_any_of("\n"));
 
-		vector<string> exifValues;
-		alg::split(exifValues, exif, alg::is_any_of("\n"));
+	string result;
+	for (int i = 0; i + 1 < exifValues.size(); ++i)
+	{
+		if (alg::starts_with(exifValues[i], "Orientation="))
+		{
+			result += "Orientation=1\n";
+		}
+		else
+		{
+			result += exifValues[i] + "\n";
+		}
+	}
 
-		for (int i = 0; i < exifValues.size(); ++i)
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+string ImageResizerMagick::sourceExif()
+{
+	if (m_master)
+	{
+		return m_exif;
+	}
+
+	string exif = m_source.attribute("EXIF:*");
+
+	vector<string> exifValues;
+	alg::split(exifValues, exif, alg::is_any_of("\n"));
+
+	string result;
+	for (int i = 0; i < exifValues.size(); ++i)
+	{
+		if (!alg::starts_with(exifValues[i], "MakerNote="))
 		{
-			if (!alg::starts_with(exifValues[i], "MakerNote="))
-			{
-				outs << exifValues[i] << "\n";
-			}
+			result += exifValues[i] + "\n";
 		}
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::writeExif(const std::string &dest)
+{
+	Trace::Span span("writeExif", "io");
+	span.arg("path", dest);
 
+	try 
+	{
+		ofstream outs(dest.c_str(), ios::out);
+
+		outs << exif();
 		outs.flush();
 
 		return true;
@@ -119,83 +488,243 @@ bool ImageResizerMagick::writeExif(const std::string &dest)
 }
 
 //-----------------------------------------------------------------------------
-bool ImageResizerMagick::fit(const Size &size)
+void ImageResizerMagick::init(const ResizeOptions &options)
 {
-	Magick::Geometry geometry(size.width(), size.height());
-	geometry.aspect(false);
-	geometry.greater(true);
+	if (!m_master)
+	{
+		m_width = m_source.columns();
+		m_height = m_source.rows();
+		m_format = m_source.magick();
+		m_orientation = m_source.orientation();
+	}
 
-	if (!geometry.isValid())
+	if (!options.isAutoOrientEnabled())
 	{
-		return false;
+		m_orientation = Magick::TopLeftOrientation;
+	}
+
+	m_oriented = m_orientation <= Magick::TopLeftOrientation;
+
+	m_prev = m_source;
+	m_shared = true;
+	m_peak_bytes = pixelBytes(m_source.columns(), m_source.rows());
+
+	if (options.isPyramidEnabled())
+	{
+		m_pyramid.reset(new ImagePyramid(m_source));
 	}
+}
 
-	m_prev.scale(geometry);
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::pad(const ResizePlan &plan, const Size &size)
+{
+	resample(plan, size);
+
+	Magick::Image background(Magick::Geometry(plan.width(), plan.height()), Magick::Color(size.background()));	
+	background.composite(m_prev, plan.offsetX(), plan.offsetY(), Magick::CopyCompositeOp);
+
+	m_peak_bytes = max(m_peak_bytes, heldBytes() + pixelBytes(plan.width(), plan.height()));
+
+	m_prev = background;
+	m_shared = false;
 	return true;
 }
 
 //-----------------------------------------------------------------------------
-bool ImageResizerMagick::stretch(const Size &size)
+bool ImageResizerMagick::crop(const ResizePlan &plan, const Size &size)
 {
-	Magick::Geometry geometry(size.width(), size.height());
-	geometry.aspect(true);
-	geometry.greater(true);
+	resample(plan, size);
+
+	MagickLib::RectangleInfo geometry;
+	geometry.width = plan.width();
+	geometry.height = plan.height();
+	geometry.x = plan.offsetX();
+	geometry.y = plan.offsetY();
+
+	MagickExceptionInfo exception;
+	replace(MagickLib::CropImage(m_prev.constImage(), &geometry, &exception.info), exception.info);
+
+	return true;
+}
 
-	if (!geometry.isValid())
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::resample(const ResizePlan &plan, const Size &size)
+{
+	// Scale dimensions in frame of previous image
+	bool swap = !m_oriented && isTransposed();
+	unsigned int width = swap ? plan.scaleHeight() : plan.scaleWidth();
+	unsigned int height = swap ? plan.scaleWidth() : plan.scaleHeight();
+
+	if (m_prev.columns() != width || m_prev.rows() != height)
 	{
-		return false;
+		resample(width, height, size);
 	}
 
-	m_prev.scale(geometry);
+	// Rotating small result is much cheaper than rotating source
+	orient();
+
 	return true;
 }
 
 //-----------------------------------------------------------------------------
-bool ImageResizerMagick::pad(const Size &size)
+void ImageResizerMagick::resample(unsigned int width, unsigned int height, const Size &size)
 {
-	Magick::Geometry geometry(size.width(), size.height());
-	geometry.aspect(false);
-	geometry.greater(true);
+	// Operations read previous image through const view and create new destination 
+	// sized image, in place Magick++ operations would first copy shared source pixels
+	const MagickLib::Image *input = m_prev.constImage();
+	double pixels = (double)input->columns * input->rows;
+
+	MagickExceptionInfo exception;
 
-	if (!geometry.isValid())
+	if (!size.filter().empty())
 	{
-		return false;
+		Stats::Timer timer(string("resample.filter.") + size.filter(), pixels);
+
+		MagickLib::FilterTypes filter;
+		if (size.filter() == Size::Filter::BOX)
+		{
+			filter = Magick::BoxFilter;
+		}
+		else if (size.filter() == Size::Filter::TRIANGLE)
+		{
+			filter = Magick::TriangleFilter;
+		}
+		else if (size.filter() == Size::Filter::CATROM)
+		{
+			filter = Magick::CatromFilter;
+		}
+		else
+		{
+			filter = Magick::LanczosFilter;
+		}
+
+		replace(MagickLib::ResizeImage(input, width, height, filter, input->blur, &exception.info), exception.info);
 	}
+	else if (m_tier == QualityTier::DRAFT)
+	{
+		Stats::Timer timer(string("resample.tier.") + m_tier, pixels);
 
-	m_prev.scale(geometry);
+		// Cheap point sampling down to twice the destination size, 
+		// then box averaging of the remaining part to suppress aliasing
+		if (input->columns > width * 2 && input->rows > height * 2)
+		{
+			replace(MagickLib::SampleImage(input, width * 2, height * 2, &exception.info), exception.info);
+		}
 
-	Magick::Image background(geometry, Magick::Color(size.background()));	
-	background.composite(m_prev, Magick::CenterGravity, Magick::CopyCompositeOp);
+		replace(MagickLib::ScaleImage(m_prev.constImage(), width, height, &exception.info), exception.info);
+	}
+	else if (m_tier == QualityTier::HIGH)
+	{
+		Stats::Timer timer(string("resample.tier.") + m_tier, pixels);
 
-	m_prev = background;
-	return true;
+		replace(MagickLib::ResizeImage(input, width, height, Magick::LanczosFilter, input->blur, &exception.info), 
+				exception.info);
+	}
+	else
+	{
+		Stats::Timer timer(string("resample.tier.") + m_tier, pixels);
+
+		replace(MagickLib::ScaleImage(input, width, height, &exception.info), exception.info);
+	}
 }
 
 //-----------------------------------------------------------------------------
-bool ImageResizerMagick::crop(const Size &size)
+void ImageResizerMagick::replace(MagickLib::Image *image, MagickLib::ExceptionInfo &exception)
 {
-	Magick::Geometry sourceSize = m_prev.size();
-	Magick::Geometry cropSize(size.width(), size.height());
-	Magick::Geometry destSize;
+	if (image)
+	{
+		// Source, pyramid, previous image and result are all held at this point
+		m_peak_bytes = max(m_peak_bytes, heldBytes() + pixelBytes(image->columns, image->rows));
 
-    double dx = (double)size.width() / sourceSize.width();
-    double dy = (double)size.height() / sourceSize.height();
+		if (m_shared)
+		{
+			// In place operation would have copied all pixels of source first
+			Stats::instance().add("copy.avoided", 0, (double)m_prev.columns() * m_prev.rows());
+		}
 
-	if (dx > dy)
+		m_prev = Magick::Image(image);
+		m_shared = false;
+	}
+
+	Magick::throwException(exception);
+}
+
+//-----------------------------------------------------------------------------
+double ImageResizerMagick::heldBytes() const
+{
+	double bytes = pixelBytes(m_source.columns(), m_source.rows());
+
+	if (m_pyramid)
 	{
-		destSize.width(size.width());
-		destSize.height(sourceSize.height() * dx);
-		cropSize.yOff((destSize.height() - size.height()) / 2);		
+		bytes += m_pyramid->bytes();
 	}
-	else
+
+	if (!m_shared)
 	{
-		destSize.height(size.height());
-		destSize.width(sourceSize.width() * dy);
-		cropSize.xOff((destSize.width() - size.width()) / 2);
+		bytes += pixelBytes(m_prev.columns(), m_prev.rows());
 	}
 
-	m_prev.scale(destSize);
-	m_prev.crop(cropSize);	
+	return bytes;
+}
 
-	return true;
+//-----------------------------------------------------------------------------
+bool ImageResizerMagick::isTransposed() const
+{
+	return m_orientation == Magick::LeftTopOrientation 
+		|| m_orientation == Magick::RightTopOrientation 
+		|| m_orientation == Magick::RightBottomOrientation 
+		|| m_orientation == Magick::LeftBottomOrientation;
+}
+
+//-----------------------------------------------------------------------------
+void ImageResizerMagick::orient()
+{
+	if (m_oriented)
+	{
+		return;
+	}
+
+	Trace::Span span("orient", "cpu");
+
+	MagickExceptionInfo exception;
+
+	// Transpose and transverse are done as rotation and mirror
+	switch (m_orientation)
+	{
+	case Magick::TopRightOrientation:
+		replace(MagickLib::FlopImage(m_prev.constImage(), &exception.info), exception.info);
+		break;
+
+	case Magick::BottomRightOrientation:
+		replace(MagickLib::RotateImage(m_prev.constImage(), 180, &exception.info), exception.info);
+		break;
+
+	case Magick::BottomLeftOrientation:
+		replace(MagickLib::FlipImage(m_prev.constImage(), &exception.info), exception.info);
+		break;
+
+	case Magick::LeftTopOrientation:
+		replace(MagickLib::RotateImage(m_prev.constImage(), 90, &exception.info), exception.info);
+		replace(MagickLib::FlopImage(m_prev.constImage(), &exception.info), exception.info);
+		break;
+
+	case Magick::RightTopOrientation:
+		replace(MagickLib::RotateImage(m_prev.constImage(), 90, &exception.info), exception.info);
+		break;
+
+	case Magick::RightBottomOrientation:
+		replace(MagickLib::RotateImage(m_prev.constImage(), 270, &exception.info), exception.info);
+		replace(MagickLib::FlopImage(m_prev.constImage(), &exception.info), exception.info);
+		break;
+
+	case Magick::LeftBottomOrientation:
+		replace(MagickLib::RotateImage(m_prev.constImage(), 270, &exception.info), exception.info);
+		break;
+
+	default:
+		break;
+	}
+
+	m_prev.orientation(Magick::TopLeftOrientation);
+	m_oriented = true;
 }
@@ -3,9 +3,13 @@
 #define _IMAGE_RESIZER_GRAPHICS_MAGICK_H 
 
 #include "ImageResizer.h"
+#include "ImagePyramid.h"
+#include "ResizePlan.h"
 
 #include <Magick++.h>
 
+#include <boost/scoped_ptr.hpp>
+
 /**
  * Image resizer implemented using GrphicsMagick
  */
@@ -14,16 +18,35 @@ class ImageResizerMagick
 {
 public:
 	/**
-	 * Create resizer
+	 * Create resizer from file, or from its cached master if master cache is enabled
+	 */
+	ImageResizerMagick(const std::string &source, const ResizeOptions &options);
+
+	/**
+	 * Create resizer from encoded image in memory
 	 */
-	ImageResizerMagick(const std::string &source);
-	ImageResizerMagick(const std::string &source, const std::string &size);
+	ImageResizerMagick(const void *data, size_t length, const ResizeOptions &options);
 
 	/**
 	 * Destructor
 	 */
 	virtual ~ImageResizerMagick();
 
+	/**
+	 * Read image dimensions and format from file header
+	 */
+	static bool ping(const std::string &file, unsigned int &width, unsigned int &height, std::string &format);
+
+	/**
+	 * Read image dimensions from header of encoded image in memory
+	 */
+	static bool ping(const void *data, size_t length, unsigned int &width, unsigned int &height);
+
+	/**
+	 * Limit OpenMP threads of calling thread, 0 restores default
+	 */
+	static void threads(unsigned int count);
+
 public:
 	/**
 	 * Resize operation
@@ -32,30 +55,113 @@ public:
 	 */
 	virtual bool resize(const std::string &dest, const Size &size);
 
+	/**
+	 * Resize operation encoding result to memory in source format
+	 * @param blob Encoded result.
+	 * @param size Resizing parameters.
+	 */
+	virtual bool resizeToBlob(std::string &blob, const Size &size);
+
+	/**
+	 * Encoding format of source
+	 */
+	virtual std::string format() const;
+
+	/**
+	 * Dimensions of original source
+	 */
+	virtual unsigned int width() const;
+	virtual unsigned int height() const;
+
+	/**
+	 * Check that image in hand has enough resolution for size
+	 */
+	virtual bool covers(const Size &size) const;
+
+	/**
+	 * Get exif info as "name=value" lines, Orientation is reset 
+	 * to 1 when results are auto-oriented
+	 */
+	virtual std::string exif();
+
 	/**
 	 * Writes exif info to specified file
 	 */
 	virtual bool writeExif(const std::string &dest);
 
 private:
-	// Resize with FIT strategy
-	bool fit(const Size &size);
+	// Prepare resizing state after source is read
+	void init(const ResizeOptions &options);
+
+	// Resize previous or source image into m_prev
+	bool apply(const Size &size);
+
+	// Exif of source as "name=value" lines, without maker note
+	std::string sourceExif();
 
-	// Resize with STRETCH strategy
-	bool stretch(const Size &size);
 
 	// Resize with PAD strategy
-	bool pad(const Size &size);
+	bool pad(const ResizePlan &plan, const Size &size);
 
 	// Resize with CROP strategy
-	bool crop(const Size &size);
+	bool crop(const ResizePlan &plan, const Size &size);
+
+	// Resample previous image to plan scale dimensions 
+	// and bring it to display orientation
+	bool resample(const ResizePlan &plan, const Size &size);
+
+	// Resample previous image using size filter or quality tier
+	void resample(unsigned int width, unsigned int height, const Size &size);
+
+	// Make result of GM operation previous image, throws on operation error
+	void replace(MagickLib::Image *image, MagickLib::ExceptionInfo &exception);
+
+	// Pixel memory held by source, pyramid and previous image
+	double heldBytes() const;
+
+	// Does source orientation swap width and height
+	bool isTransposed() const;
+
+	// Rotate or mirror previous image to display orientation
+	void orient();
 
 private:
-	// Source
+	// Source, or its master
 	Magick::Image m_source;
 
+	// Original source dimensions, sizes are planned from them
+	unsigned int m_width;
+	unsigned int m_height;
+
+	// Original source format
+	std::string m_format;
+
+	// Exif orientation of source
+	Magick::OrientationType m_orientation;
+
+	// Is previous image in display orientation
+	bool m_oriented;
+
+	// Source opened from cached master
+	bool m_master;
+
+	// Exif of cached master
+	std::string m_exif;
+
 	// Previous resized image
 	Magick::Image m_prev;
+
+	// Previous image references source or pyramid level and must not be modified in place
+	bool m_shared;
+
+	// Largest pixel memory held at once
+	double m_peak_bytes;
+
+	// Quality tier
+	std::string m_tier;
+
+	// Source pyramid, null if disabled
+	boost::scoped_ptr<ImagePyramid> m_pyramid;
 };
 
 #endif
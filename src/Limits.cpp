@@ -0,0 +1,117 @@
+#include "Limits.h"
+#include "Stats.h"
+
+#include <sstream>
+
+#include <magick/api.h>
+
+using namespace std;
+
+
+// Deadline of current thread, 0 when not limited. Progress monitor may be 
+// called from OpenMP threads of parallel regions, which see no deadline, 
+// those regions are then checked by their caller once they finish.
+static __thread double t_deadline = 0;
+static __thread const char *t_reason = NULL;
+static __thread unsigned int t_ms = 0;
+
+// Progress monitor of embedding application, installed before ours
+static MagickLib::MonitorHandler s_previous = NULL;
+
+// Cancels GM operation once deadline passes, otherwise passes progress on
+static MagickLib::MagickPassFail monitor(const char *text, const MagickLib::magick_int64_t quantum, 
+											const MagickLib::magick_uint64_t span, MagickLib::ExceptionInfo *exception)
+{
+	if (t_deadline == 0 || Stats::now() < t_deadline)
+	{
+		return s_previous ? s_previous(text, quantum, span, exception) : MagickPass;
+	}
+
+	MagickLib::ThrowException(exception, MonitorError, "time limit exceeded", text);
+	return MagickFail;
+}
+
+
+//-----------------------------------------------------------------------------
+Limits::Exceeded::Exceeded(const string &reason, const string &message)
+	:runtime_error(message)
+	,m_reason(reason)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Limits::Exceeded::~Exceeded() throw()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+const string &Limits::Exceeded::reason() const
+{
+	return m_reason;
+}
+
+//-----------------------------------------------------------------------------
+Limits::Deadline::Deadline(const char *reason, unsigned int ms)
+	:m_outer(t_deadline)
+	,m_outer_reason(t_reason)
+	,m_outer_ms(t_ms)
+{
+	double deadline = Stats::now() + ms;
+
+	if (ms && (t_deadline == 0 || deadline < t_deadline))
+	{
+		t_deadline = deadline;
+		t_reason = reason;
+		t_ms = ms;
+	}
+}
+
+//-----------------------------------------------------------------------------
+Limits::Deadline::~Deadline()
+{
+	t_deadline = m_outer;
+	t_reason = m_outer_reason;
+	t_ms = m_outer_ms;
+}
+
+//-----------------------------------------------------------------------------
+void Limits::install()
+{
+	MagickLib::MonitorHandler previous = MagickLib::SetMonitorHandler(monitor);
+	if (previous != monitor)
+	{
+		s_previous = previous;
+	}
+}
+
+//-----------------------------------------------------------------------------
+void Limits::check()
+{
+	if (t_deadline == 0 || Stats::now() < t_deadline)
+	{
+		return;
+	}
+
+	ostringstream message;
+	message << t_reason << " time limit of " << t_ms << " ms exceeded";
+
+	throw Exceeded(t_reason, message.str());
+}
+
+//-----------------------------------------------------------------------------
+void Limits::pixels(unsigned int width, unsigned int height, double max)
+{
+	double pixels = (double)width * height;
+
+	if (max <= 0 || pixels <= max)
+	{
+		return;
+	}
+
+	ostringstream message;
+	message << "declared " << width << "x" << height << " exceeds limit of " << max / 1e6 << " megapixels";
+
+	throw Exceeded("pixels", message.str());
+}
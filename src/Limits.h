@@ -0,0 +1,93 @@
+#ifndef _LIMITS_H
+#define _LIMITS_H 
+
+#include <string>
+#include <stdexcept>
+
+/**
+ * Per file limits containing decompression bombs and pathological files. 
+ * Declared pixels are checked from image header before decode, time 
+ * limits are per thread deadlines checked by GraphicsMagick progress 
+ * monitor during decode and resampling, so long operations are cancelled 
+ * instead of running to completion.
+ */
+class Limits
+{
+public:
+	/**
+	 * Thrown when file exceeds some limit
+	 */
+	class Exceeded
+		:public std::runtime_error
+	{
+	public:
+		/**
+		 * @param reason Limit name, e.g. "pixels".
+		 * @param message Description.
+		 */
+		Exceeded(const std::string &reason, const std::string &message);
+
+		virtual ~Exceeded() throw();
+
+		/**
+		 * Limit name: "pixels", "decode" or "file"
+		 */
+		const std::string &reason() const;
+
+	private:
+		// Limit name
+		std::string m_reason;
+	};
+
+	/**
+	 * Sets deadline of calling thread from construction to destruction. 
+	 * Nested deadlines can only shorten outer ones.
+	 */
+	class Deadline
+	{
+	public:
+		/**
+		 * @param reason Limit name reported when deadline passes.
+		 * @param ms Time limit in milliseconds, 0 for none.
+		 */
+		Deadline(const char *reason, unsigned int ms);
+
+		/**
+		 * Restore outer deadline
+		 */
+		~Deadline();
+
+	private:
+		Deadline(const Deadline &);
+
+	private:
+		// Outer deadline
+		double m_outer;
+
+		// Outer limit name
+		const char *m_outer_reason;
+
+		// Outer limit in ms
+		unsigned int m_outer_ms;
+	};
+
+public:
+	/**
+	 * Install GraphicsMagick progress monitor, called once on GM initialization.
+	 * Monitor installed before by embedding application keeps receiving progress.
+	 */
+	static void install();
+
+	/**
+	 * Throw Exceeded if deadline of calling thread has passed
+	 */
+	static void check();
+
+	/**
+	 * Throw Exceeded if declared dimensions exceed limit
+	 * @param max Pixel limit, 0 for none.
+	 */
+	static void pixels(unsigned int width, unsigned int height, double max);
+};
+
+#endif
@@ -0,0 +1,22 @@
+#include "MagickExceptionInfo.h"
+
+#include <magick/api.h>
+
+
+//-----------------------------------------------------------------------------
+MagickExceptionInfo::MagickExceptionInfo()
+{
+	MagickLib::GetExceptionInfo(&info);
+}
+
+//-----------------------------------------------------------------------------
+MagickExceptionInfo::~MagickExceptionInfo()
+{
+	MagickLib::DestroyExceptionInfo(&info);
+}
+
+//-----------------------------------------------------------------------------
+void MagickExceptionInfo::check()
+{
+	Magick::throwException(info);
+}
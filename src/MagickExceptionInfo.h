@@ -0,0 +1,31 @@
+#ifndef _MAGICK_EXCEPTION_INFO_H
+#define _MAGICK_EXCEPTION_INFO_H 
+
+#include <Magick++.h>
+
+/**
+ * Exception info of GM C API call, initialized on construction 
+ * and destroyed on scope exit, also when the call throws.
+ */
+class MagickExceptionInfo
+{
+public:
+	MagickExceptionInfo();
+
+	~MagickExceptionInfo();
+
+public:
+	/**
+	 * Throw Magick::Exception if the call reported an error
+	 */
+	void check();
+
+public:
+	MagickLib::ExceptionInfo info;
+
+private:
+	MagickExceptionInfo(const MagickExceptionInfo &);
+	MagickExceptionInfo &operator=(const MagickExceptionInfo &);
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "MasterCache.h"
+#include "Hash.h"
+#include "MagickExceptionInfo.h"
+#include "Stats.h"
+#include "Trace.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <magick/api.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+
+//-----------------------------------------------------------------------------
+MasterCache::Info::Info()
+	:width(0)
+	,height(0)
+	,orientation(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+MasterCache::MasterCache(const string &dir, unsigned int size, const string &source_size)
+	:m_dir(dir)
+	,m_size(size)
+	,m_source_size(source_size)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+MasterCache::~MasterCache()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+bool MasterCache::load(const string &file, Magick::Image &master, Info &info) const
+{
+	string entry = path(file);
+	if (entry.empty())
+	{
+		return false;
+	}
+
+	ifstream ins((entry + ".info").c_str(), ios::in | ios::binary);
+
+	// First line is "width height format orientation", rest of info is exif
+	string line;
+	getline(ins, line);
+
+	istringstream header(line);
+	if (!(header >> info.width >> info.height >> info.format >> info.orientation) 
+		|| info.width == 0 || info.height == 0)
+	{
+		Stats::instance().add("master.miss", 0);
+		return false;
+	}
+
+	ostringstream exif;
+	exif << ins.rdbuf();
+	info.exif = exif.str();
+
+	try
+	{
+		Trace::Span span("master.load", "io");
+		Stats::Timer timer("master.load");
+
+		master.read(entry + ".miff");
+	}
+	catch (std::exception &)
+	{
+		Stats::instance().add("master.miss", 0);
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool MasterCache::store(const string &file, const Magick::Image &source, const Info &info) const
+{
+	string entry = path(file);
+	if (entry.empty())
+	{
+		return false;
+	}
+
+	Trace::Span span("master.store", "io");
+	Stats::Timer timer("master.store", (double)source.columns() * source.rows());
+
+	try
+	{
+		fs::create_directories(fs::path(entry).parent_path());
+
+		Magick::Image master(source);
+		unsigned int long_edge = max(source.columns(), source.rows());
+
+		if (long_edge > m_size)
+		{
+			// One time cost, so use the best filter. Resized from const view 
+			// of source, resizing copy in place would duplicate source pixels.
+			double scale = (double)m_size / long_edge;
+			unsigned long width = max(1u, (unsigned int)floor(source.columns() * scale + 0.5));
+			unsigned long height = max(1u, (unsigned int)floor(source.rows() * scale + 0.5));
+
+			MagickExceptionInfo exception;
+			MagickLib::Image *image = MagickLib::ResizeImage(source.constImage(), width, height, 
+																Magick::LanczosFilter, 1.0, &exception.info);
+			if (image)
+			{
+				master = Magick::Image(image);
+			}
+
+			exception.check();
+
+			if (!image)
+			{
+				throw runtime_error("Can not resize master");
+			}
+		}
+
+		master.strip();
+
+		// Write to temporary names and rename, so readers never see partial entry
+		string pid = boost::lexical_cast<string>(getpid());
+		string tmp_image = entry + ".miff." + pid;
+		string tmp_info = entry + ".info." + pid;
+
+		master.write(string("MIFF:") + tmp_image);
+
+		ofstream outs(tmp_info.c_str(), ios::out | ios::binary | ios::trunc);
+		outs << info.width << " " << info.height << " " << info.format << " " << info.orientation << "\n" << info.exif;
+		outs.close();
+
+		if (!outs 
+			|| rename(tmp_image.c_str(), (entry + ".miff").c_str()) != 0 
+			|| rename(tmp_info.c_str(), (entry + ".info").c_str()) != 0)
+		{
+			remove(tmp_image.c_str());
+			remove(tmp_info.c_str());
+			return false;
+		}
+	}
+	catch (std::exception &ex)
+	{
+		// Source is still resized, only the cache entry is lost
+		Stats::instance().add("master.store.failed", 0);
+		span.arg("error", ex.what());
+
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+string MasterCache::path(const string &file) const
+{
+	boost::system::error_code error;
+
+	fs::path absolute = fs::absolute(file);
+	uintmax_t size = fs::file_size(absolute, error);
+	time_t mtime = error ? 0 : fs::last_write_time(absolute, error);
+
+	if (error)
+	{
+		return "";
+	}
+
+	ostringstream identity;
+	identity << absolute.native() << "\n" << size << "\n" << mtime << "\n" << m_size << "\n" << m_source_size;
+
+	string name = Hash::hex(Hash::fnv1a(identity.str()));
+	return (fs::path(m_dir) / name.substr(0, 2) / name).native();
+}
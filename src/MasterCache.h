@@ -0,0 +1,85 @@
+
+#ifndef _MASTER_CACHE_H
+#define _MASTER_CACHE_H 
+
+#include <string>
+
+#include <Magick++.h>
+
+/**
+ * Persistent cache of reduced resolution "master" copies of sources.
+ * Master is stored as uncompressed MIFF (fast to read, lossless) with
+ * sidecar info file holding source dimensions, format, orientation and exif. 
+ * Entries are keyed by FNV-1a of source identity: absolute path, size, 
+ * modification time, master size and source size hint, so changed sources 
+ * are cached again and keys survive library upgrades.
+ *
+ * Layout: <dir>/<key[0..1]>/<key>.miff and <dir>/<key[0..1]>/<key>.info
+ */
+class MasterCache
+{
+public:
+	/**
+	 * Cached source description
+	 */
+	struct Info
+	{
+		Info();
+
+		// Source dimensions
+		unsigned int width;
+		unsigned int height;
+
+		// Source encoding format
+		std::string format;
+
+		// Source exif orientation, master is stored unrotated
+		int orientation;
+
+		// Source exif info
+		std::string exif;
+	};
+
+public:
+	/**
+	 * Create cache
+	 * @param dir Cache directory.
+	 * @param size Long edge of master in pixels.
+	 * @param source_size Size hint sources are decoded with, e.g. "1024x1024".
+	 */
+	MasterCache(const std::string &dir, unsigned int size, const std::string &source_size);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~MasterCache();
+
+public:
+	/**
+	 * Load master of source
+	 * @return false if there is no valid master.
+	 */
+	bool load(const std::string &file, Magick::Image &master, Info &info) const;
+
+	/**
+	 * Make master from decoded source and store it
+	 * @return false if master can not be written.
+	 */
+	bool store(const std::string &file, const Magick::Image &source, const Info &info) const;
+
+private:
+	// Path of entry without extension, empty if source can not be identified
+	std::string path(const std::string &file) const;
+
+private:
+	// Cache directory
+	std::string m_dir;
+
+	// Long edge of master
+	unsigned int m_size;
+
+	// Source decoding size hint
+	std::string m_source_size;
+};
+
+#endif
@@ -0,0 +1,256 @@
+#include "Metrics.h"
+#include "Stats.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+#include <unistd.h>
+
+#include <boost/bind/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+using namespace std;
+
+
+// Histogram bucket upper bounds in seconds
+static const double BUCKETS[] = { 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30 };
+static const size_t BUCKET_COUNT = sizeof(BUCKETS) / sizeof(BUCKETS[0]);
+
+
+//-----------------------------------------------------------------------------
+Metrics::Histogram::Histogram()
+	:buckets(BUCKET_COUNT + 1, 0)
+	,sum(0)
+	,count(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Metrics::Metrics()
+	:m_enabled(false)
+	,m_start(0)
+	,m_queued(0)
+	,m_files(0)
+	,m_pixels(0)
+	,m_bytes_in(0)
+	,m_bytes_out(0)
+	,m_stopping(false)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Metrics &Metrics::instance()
+{
+	static Metrics metrics;
+	return metrics;
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::enable()
+{
+	m_start = Stats::now();
+	m_enabled = true;
+}
+
+//-----------------------------------------------------------------------------
+bool Metrics::isEnabled() const
+{
+	return m_enabled;
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::queue(size_t files)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_queued = files;
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::file(double bytes)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_files++;
+	m_bytes_in += bytes;
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::output(double pixels, double bytes)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_pixels += pixels;
+	m_bytes_out += bytes;
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::error(const string &type)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_errors[type]++;
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::observe(const string &stage, double seconds)
+{
+	size_t bucket = 0;
+	while (bucket < BUCKET_COUNT && seconds > BUCKETS[bucket])
+	{
+		bucket++;
+	}
+
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	Histogram &histogram = m_stages[stage];
+	histogram.buckets[bucket]++;
+	histogram.sum += seconds;
+	histogram.count++;
+}
+
+//-----------------------------------------------------------------------------
+bool Metrics::write(const string &path) const
+{
+	ostringstream outs;
+	outs.precision(15);
+
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+
+		unsigned long failed = 0;
+		for (map<string, unsigned long>::const_iterator it = m_errors.begin(); it != m_errors.end(); ++it)
+		{
+			failed += it->second;
+		}
+
+		// Remaining time from average file rate so far
+		double elapsed = (Stats::now() - m_start) / 1000.0;
+		unsigned long done = m_files + failed;
+		size_t remaining = m_queued > done ? m_queued - done : 0;
+		double eta = done ? remaining * elapsed / done : 0;
+
+		outs << "# HELP phresizer_files_total Processed source files.\n"
+				<< "# TYPE phresizer_files_total counter\n"
+				<< "phresizer_files_total " << m_files << "\n";
+
+		outs << "# HELP phresizer_pixels_total Decoded source pixels.\n"
+				<< "# TYPE phresizer_pixels_total counter\n"
+				<< "phresizer_pixels_total " << m_pixels << "\n";
+
+		outs << "# HELP phresizer_bytes_in_total Read source bytes.\n"
+				<< "# TYPE phresizer_bytes_in_total counter\n"
+				<< "phresizer_bytes_in_total " << m_bytes_in << "\n";
+
+		outs << "# HELP phresizer_bytes_out_total Written output image bytes.\n"
+				<< "# TYPE phresizer_bytes_out_total counter\n"
+				<< "phresizer_bytes_out_total " << m_bytes_out << "\n";
+
+		outs << "# HELP phresizer_errors_total Failed source files by error type.\n"
+				<< "# TYPE phresizer_errors_total counter\n";
+
+		for (map<string, unsigned long>::const_iterator it = m_errors.begin(); it != m_errors.end(); ++it)
+		{
+			outs << "phresizer_errors_total{type=\"" << it->first << "\"} " << it->second << "\n";
+		}
+
+		outs << "# HELP phresizer_queue_files Files not yet processed.\n"
+				<< "# TYPE phresizer_queue_files gauge\n"
+				<< "phresizer_queue_files " << remaining << "\n";
+
+		outs << "# HELP phresizer_elapsed_seconds Time since batch start.\n"
+				<< "# TYPE phresizer_elapsed_seconds gauge\n"
+				<< "phresizer_elapsed_seconds " << elapsed << "\n";
+
+		outs << "# HELP phresizer_eta_seconds Estimated time remaining.\n"
+				<< "# TYPE phresizer_eta_seconds gauge\n"
+				<< "phresizer_eta_seconds " << eta << "\n";
+
+		outs << "# HELP phresizer_stage_seconds Latency of pipeline stages.\n"
+				<< "# TYPE phresizer_stage_seconds histogram\n";
+
+		for (map<string, Histogram>::const_iterator it = m_stages.begin(); it != m_stages.end(); ++it)
+		{
+			const Histogram &histogram = it->second;
+
+			unsigned long cumulative = 0;
+			for (size_t i = 0; i <= BUCKET_COUNT; ++i)
+			{
+				cumulative += histogram.buckets[i];
+
+				outs << "phresizer_stage_seconds_bucket{stage=\"" << it->first << "\",le=\"";
+				if (i < BUCKET_COUNT)
+				{
+					outs << BUCKETS[i];
+				}
+				else
+				{
+					outs << "+Inf";
+				}
+				outs << "\"} " << cumulative << "\n";
+			}
+
+			outs << "phresizer_stage_seconds_sum{stage=\"" << it->first << "\"} " << histogram.sum << "\n";
+			outs << "phresizer_stage_seconds_count{stage=\"" << it->first << "\"} " << histogram.count << "\n";
+		}
+	}
+
+	// Collector must never read partially written file
+	string tmp = path + "." + boost::lexical_cast<string>(getpid());
+
+	ofstream file(tmp.c_str(), ios::out | ios::trunc);
+	file << outs.str();
+	file.close();
+
+	if (!file || rename(tmp.c_str(), path.c_str()) != 0)
+	{
+		remove(tmp.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::start(const string &path, unsigned int interval)
+{
+	if (m_thread)
+	{
+		return;
+	}
+
+	m_stopping = false;
+	m_thread.reset(new boost::thread(boost::bind(&Metrics::run, this, path, interval)));
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::stop()
+{
+	if (!m_thread)
+	{
+		return;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(m_stop_mutex);
+		m_stopping = true;
+		m_stop.notify_all();
+	}
+
+	m_thread->join();
+	m_thread.reset();
+}
+
+//-----------------------------------------------------------------------------
+void Metrics::run(string path, unsigned int interval)
+{
+	boost::mutex::scoped_lock lock(m_stop_mutex);
+
+	while (!m_stopping)
+	{
+		m_stop.timed_wait(lock, boost::posix_time::seconds(interval));
+
+		lock.unlock();
+		write(path);
+		lock.lock();
+	}
+}
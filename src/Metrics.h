@@ -0,0 +1,152 @@
+#ifndef _METRICS_H
+#define _METRICS_H 
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+/**
+ * Live batch metrics in Prometheus text exposition format, meant for 
+ * node_exporter textfile collector: processed files, pixels and bytes, 
+ * per stage latency histograms (fed by Trace spans), errors by type, 
+ * queue depth and estimated time remaining. 
+ * File is rewritten atomically (temporary file and rename) periodically 
+ * by background thread. Collection is off by default. Thread safe.
+ */
+class Metrics
+{
+public:
+	/**
+	 * Get global metrics instance
+	 */
+	static Metrics &instance();
+
+	/**
+	 * Start collecting
+	 */
+	void enable();
+
+	/**
+	 * Is collecting
+	 */
+	bool isEnabled() const;
+
+	/**
+	 * Set count of queued files, used for queue depth and remaining time
+	 */
+	void queue(size_t files);
+
+	/**
+	 * Count processed file
+	 * @param bytes Source file size.
+	 */
+	void file(double bytes);
+
+	/**
+	 * Count decoded source pixels and encoded output bytes
+	 */
+	void output(double pixels, double bytes);
+
+	/**
+	 * Count failed file
+	 * @param type Error type, e.g. exception class name.
+	 */
+	void error(const std::string &type);
+
+	/**
+	 * Add stage latency to histogram
+	 * @param stage Stage name, e.g. "decode".
+	 * @param seconds Stage duration.
+	 */
+	void observe(const std::string &stage, double seconds);
+
+	/**
+	 * Write metrics to file atomically
+	 * @return false if file can not be written.
+	 */
+	bool write(const std::string &path) const;
+
+	/**
+	 * Start rewriting file periodically
+	 * @param path Metrics file, should end with ".prom" for textfile collector.
+	 * @param interval Seconds between rewrites.
+	 */
+	void start(const std::string &path, unsigned int interval);
+
+	/**
+	 * Stop periodic rewriting and write final metrics
+	 */
+	void stop();
+
+private:
+	Metrics();
+
+	// Periodic writer thread body
+	void run(std::string path, unsigned int interval);
+
+private:
+	// Latency histogram
+	struct Histogram
+	{
+		Histogram();
+
+		// Observations per bucket, not cumulative, last one is +Inf
+		std::vector<unsigned long> buckets;
+
+		// Sum of observed seconds
+		double sum;
+
+		// Count of observations
+		unsigned long count;
+	};
+
+	// Collecting flag
+	volatile bool m_enabled;
+
+	// Collection start, ms
+	double m_start;
+
+	// Queued files
+	size_t m_queued;
+
+	// Processed files
+	unsigned long m_files;
+
+	// Decoded source pixels
+	double m_pixels;
+
+	// Read source bytes
+	double m_bytes_in;
+
+	// Written output bytes
+	double m_bytes_out;
+
+	// Failed files by error type
+	std::map<std::string, unsigned long> m_errors;
+
+	// Latency by stage
+	std::map<std::string, Histogram> m_stages;
+
+	// Guards values
+	mutable boost::mutex m_mutex;
+
+	// Periodic writer
+	boost::scoped_ptr<boost::thread> m_thread;
+
+	// Writer stop request
+	bool m_stopping;
+
+	// Guards stop request
+	boost::mutex m_stop_mutex;
+
+	// Signals stop request
+	boost::condition_variable m_stop;
+};
+
+#endif
@@ -0,0 +1,171 @@
+#include "Numa.h"
+
+#include <fstream>
+#include <cstdlib>
+
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/thread/thread.hpp>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+namespace alg = boost::algorithm;
+
+
+//-----------------------------------------------------------------------------
+Numa::Numa()
+{
+#ifdef __linux__
+	fs::path root("/sys/devices/system/node");
+
+	boost::system::error_code error;
+	if (fs::is_directory(root, error))
+	{
+		for (fs::directory_iterator it(root, error); it != fs::directory_iterator(); ++it)
+		{
+			string name = it->path().filename().native();
+			if (!alg::starts_with(name, "node") || name.size() < 5 
+				|| name.find_first_not_of("0123456789", 4) != string::npos)
+			{
+				continue;
+			}
+
+			ifstream ins((it->path() / "cpulist").native().c_str());
+			string list;
+			getline(ins, list);
+
+			vector<int> cpus = parseCpuList(list);
+			if (!cpus.empty())
+			{
+				m_node_ids.push_back(atoi(name.c_str() + 4));
+				m_cpus.push_back(cpus);
+			}
+		}
+	}
+#endif
+
+	// Fallback: one node with all CPUs
+	if (m_cpus.empty())
+	{
+		vector<int> cpus;
+		unsigned int count = boost::thread::hardware_concurrency();
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			cpus.push_back(i);
+		}
+
+		m_node_ids.push_back(0);
+		m_cpus.push_back(cpus);
+	}
+}
+
+//-----------------------------------------------------------------------------
+Numa::~Numa()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Numa::nodes() const
+{
+	return m_cpus.size();
+}
+
+//-----------------------------------------------------------------------------
+const vector<int> &Numa::cpus(unsigned int node) const
+{
+	return m_cpus[node % m_cpus.size()];
+}
+
+//-----------------------------------------------------------------------------
+bool Numa::bind(unsigned int node) const
+{
+	node = node % m_cpus.size();
+
+	if (!affinity(m_cpus[node]))
+	{
+		return false;
+	}
+
+#ifdef __linux__
+	// Pixel caches are allocated by the thread which decodes the image,
+	// preferred policy keeps them on this node while memory is available
+	int id = m_node_ids[node];
+	unsigned long mask[16] = { 0 };
+	if (id < 0 || id >= (int)(sizeof(mask) * 8))
+	{
+		return false;
+	}
+
+	mask[id / (sizeof(unsigned long) * 8)] |= 1UL << (id % (sizeof(unsigned long) * 8));
+	return syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, sizeof(mask) * 8) == 0;
+#else
+	return false;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+bool Numa::pin(int cpu) const
+{
+	return affinity(vector<int>(1, cpu));
+}
+
+//-----------------------------------------------------------------------------
+vector<int> Numa::parseCpuList(const string &list)
+{
+	vector<int> cpus;
+
+	vector<string> ranges;
+	alg::split(ranges, alg::trim_copy(list), alg::is_any_of(","));
+
+	for (int i = 0; i < ranges.size(); ++i)
+	{
+		if (ranges[i].empty())
+		{
+			continue;
+		}
+
+		vector<string> bounds;
+		alg::split(bounds, ranges[i], alg::is_any_of("-"));
+
+		int first = atoi(bounds[0].c_str());
+		int last = bounds.size() > 1 ? atoi(bounds[1].c_str()) : first;
+
+		for (int cpu = first; cpu <= last; ++cpu)
+		{
+			cpus.push_back(cpu);
+		}
+	}
+
+	return cpus;
+}
+
+//-----------------------------------------------------------------------------
+bool Numa::affinity(const vector<int> &cpus) const
+{
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	for (int i = 0; i < cpus.size(); ++i)
+	{
+		if (cpus[i] >= 0 && cpus[i] < CPU_SETSIZE)
+		{
+			CPU_SET(cpus[i], &set);
+		}
+	}
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
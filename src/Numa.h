@@ -0,0 +1,69 @@
+
+#ifndef _NUMA_H
+#define _NUMA_H 
+
+#include <string>
+#include <vector>
+
+/**
+ * NUMA topology of the host and placement of the calling thread. 
+ * Topology is read from /sys/devices/system/node, so no libnuma is 
+ * needed. On non-Linux hosts or without sysfs topology the host is 
+ * reported as one node and placement calls do nothing.
+ */
+class Numa
+{
+public:
+	/**
+	 * Discover topology
+	 */
+	Numa();
+
+	/**
+	 * Destructor
+	 */
+	virtual ~Numa();
+
+public:
+	/**
+	 * Count of nodes, at least 1
+	 */
+	unsigned int nodes() const;
+
+	/**
+	 * CPUs of node
+	 */
+	const std::vector<int> &cpus(unsigned int node) const;
+
+	/**
+	 * Restrict calling thread (and threads it creates later, 
+	 * e.g. OpenMP team) to CPUs of node and prefer allocating 
+	 * memory on that node
+	 * @return false if placement is not supported or failed.
+	 */
+	bool bind(unsigned int node) const;
+
+	/**
+	 * Pin calling thread to single CPU
+	 * @return false if placement is not supported or failed.
+	 */
+	bool pin(int cpu) const;
+
+	/**
+	 * Parse kernel cpu list format, e.g. "0-3,8-11"
+	 */
+	static std::vector<int> parseCpuList(const std::string &list);
+
+private:
+	// Pin calling thread to CPU set
+	bool affinity(const std::vector<int> &cpus) const;
+
+private:
+	// Node ids as known to kernel
+	std::vector<int> m_node_ids;
+
+	// CPUs by node
+	std::vector<std::vector<int> > m_cpus;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#include "Pack.h"
+
+
+const char *Pack::DATA_EXTENSION = ".pack";
+const char *Pack::INDEX_EXTENSION = ".idx";
+const char Pack::MAGIC[8] = { 'P', 'H', 'R', 'P', 'A', 'C', 'K', 0 };
+const uint32_t Pack::VERSION = 1;
+
+
+//-----------------------------------------------------------------------------
+Pack::Entry::Entry()
+	:offset(0)
+	,length(0)
+{
+
+}
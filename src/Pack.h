@@ -0,0 +1,82 @@
+
+#ifndef _PACK_H
+#define _PACK_H 
+
+#include <string>
+#include <stdint.h>
+
+/**
+ * Pack archive format shared by PackWriter and PackReader.
+ *
+ * Pack consists of two files:
+ *  <path>.pack - append-only concatenation of encoded images;
+ *  <path>.idx  - index, header followed by records sorted by entry name
+ *                and string table with names. Index is designed to be
+ *                memory mapped and binary searched in place.
+ *
+ * All integers are stored in host byte order.
+ */
+class Pack
+{
+public:
+	// Extension of data file
+	static const char *DATA_EXTENSION;
+
+	// Extension of index file
+	static const char *INDEX_EXTENSION;
+
+	// Index file magic
+	static const char MAGIC[8];
+
+	// Index format version
+	static const uint32_t VERSION;
+
+	/**
+	 * Location of entry in pack data file
+	 */
+	struct Entry
+	{
+		Entry();
+
+		// Offset in data file
+		uint64_t offset;
+
+		// Length in bytes
+		uint64_t length;
+
+		// Encoding format, e.g. "JPEG"
+		std::string format;
+	};
+
+	/**
+	 * Index file header
+	 */
+	struct IndexHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t count;
+
+		// Offset of string table from start of index file
+		uint64_t strings_offset;
+	};
+
+	/**
+	 * Index file record, records follow header
+	 */
+	struct IndexRecord
+	{
+		// Name position in string table
+		uint64_t name_offset;
+		uint32_t name_length;
+
+		// Zero padded encoding format
+		char format[12];
+
+		// Data location
+		uint64_t offset;
+		uint64_t length;
+	};
+};
+
+#endif
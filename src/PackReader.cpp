@@ -0,0 +1,201 @@
+#include "PackReader.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+PackReader::PackReader(const string &path)
+	:m_fd(-1)
+	,m_index(MAP_FAILED)
+	,m_index_length(0)
+	,m_header(NULL)
+	,m_records(NULL)
+	,m_strings(NULL)
+{
+	string index_path = path + Pack::INDEX_EXTENSION;
+	int index_fd = open(index_path.c_str(), O_RDONLY);
+	if (index_fd < 0)
+	{
+		throw runtime_error(string("Can not open pack index ") + index_path);
+	}
+
+	struct stat st;
+	if (fstat(index_fd, &st) == 0 && st.st_size >= (off_t)sizeof(Pack::IndexHeader))
+	{
+		m_index_length = st.st_size;
+		m_index = mmap(NULL, m_index_length, PROT_READ, MAP_SHARED, index_fd, 0);
+	}
+	close(index_fd);
+
+	if (m_index == MAP_FAILED)
+	{
+		throw runtime_error(string("Can not map pack index ") + index_path);
+	}
+
+	m_header = (const Pack::IndexHeader *)m_index;
+	m_records = (const Pack::IndexRecord *)(m_header + 1);
+	m_strings = (const char *)m_index + m_header->strings_offset;
+
+	if (memcmp(m_header->magic, Pack::MAGIC, sizeof(Pack::MAGIC)) != 0 
+		|| m_header->version != Pack::VERSION
+		|| m_header->strings_offset > m_index_length
+		|| sizeof(Pack::IndexHeader) + m_header->count * sizeof(Pack::IndexRecord) > m_header->strings_offset)
+	{
+		munmap(m_index, m_index_length);
+		throw runtime_error(string("Broken pack index ") + index_path);
+	}
+
+	string data_path = path + Pack::DATA_EXTENSION;
+	m_fd = open(data_path.c_str(), O_RDONLY);
+	if (m_fd < 0)
+	{
+		munmap(m_index, m_index_length);
+		throw runtime_error(string("Can not open pack ") + data_path);
+	}
+
+	// Records are used in place, so every one is checked against index and data size once
+	if (fstat(m_fd, &st) != 0 || !isValid(st.st_size))
+	{
+		munmap(m_index, m_index_length);
+		close(m_fd);
+		throw runtime_error(string("Broken pack index ") + index_path);
+	}
+}
+
+//-----------------------------------------------------------------------------
+PackReader::~PackReader()
+{
+	munmap(m_index, m_index_length);
+	close(m_fd);
+}
+
+//-----------------------------------------------------------------------------
+unsigned int PackReader::size() const
+{
+	return m_header->count;
+}
+
+//-----------------------------------------------------------------------------
+string PackReader::name(unsigned int index) const
+{
+	const Pack::IndexRecord &record = m_records[index];
+	return string(m_strings + record.name_offset, record.name_length);
+}
+
+//-----------------------------------------------------------------------------
+Pack::Entry PackReader::entry(unsigned int index) const
+{
+	const Pack::IndexRecord &record = m_records[index];
+
+	Pack::Entry entry;
+	entry.offset = record.offset;
+	entry.length = record.length;
+	entry.format = string(record.format, strnlen(record.format, sizeof(record.format)));
+
+	return entry;
+}
+
+//-----------------------------------------------------------------------------
+bool PackReader::find(const string &name, Pack::Entry &result) const
+{
+	// Binary search over sorted records
+	unsigned int low = 0;
+	unsigned int high = m_header->count;
+
+	while (low < high)
+	{
+		unsigned int middle = low + (high - low) / 2;
+		int cmp = compare(m_records[middle], name);
+
+		if (cmp == 0)
+		{
+			result = entry(middle);
+			return true;
+		}
+		else if (cmp < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+bool PackReader::read(const Pack::Entry &entry, string &data) const
+{
+	data.resize(entry.length);
+
+	size_t done = 0;
+	while (done < entry.length)
+	{
+		// Normally completes in one call, loop covers short reads
+		ssize_t count = pread(m_fd, &data[done], entry.length - done, entry.offset + done);
+		if (count <= 0)
+		{
+			return false;
+		}
+
+		done += count;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool PackReader::read(const string &name, string &data) const
+{
+	Pack::Entry found;
+	return find(name, found) && read(found, data);
+}
+
+//-----------------------------------------------------------------------------
+bool PackReader::isValid(uint64_t data_length) const
+{
+	uint64_t strings_length = m_index_length - m_header->strings_offset;
+
+	for (uint32_t i = 0; i < m_header->count; ++i)
+	{
+		const Pack::IndexRecord &record = m_records[i];
+
+		if (record.name_offset > strings_length || record.name_length > strings_length - record.name_offset
+			|| record.offset > data_length || record.length > data_length - record.offset)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+int PackReader::compare(const Pack::IndexRecord &record, const string &name) const
+{
+	size_t length = min((size_t)record.name_length, name.size());
+
+	int cmp = memcmp(m_strings + record.name_offset, name.data(), length);
+	if (cmp != 0)
+	{
+		return cmp;
+	}
+
+	if (record.name_length == name.size())
+	{
+		return 0;
+	}
+
+	return record.name_length < name.size() ? -1 : 1;
+}
@@ -0,0 +1,85 @@
+
+#ifndef _PACK_READER_H
+#define _PACK_READER_H 
+
+#include "Pack.h"
+
+#include <string>
+#include <cstddef>
+
+/**
+ * Reads entries of pack written by PackWriter. 
+ * Index is memory mapped and searched in place, every entry is 
+ * read with a single pread. All methods are const and thread safe.
+ */
+class PackReader
+{
+public:
+	/**
+	 * Open pack
+	 * @param path Pack path without extension.
+	 * @throws std::runtime_error if pack can not be opened or index is broken.
+	 */
+	PackReader(const std::string &path);
+
+	/**
+	 * Close pack
+	 */
+	virtual ~PackReader();
+
+public:
+	/**
+	 * Count of entries
+	 */
+	unsigned int size() const;
+
+	/**
+	 * Name of entry by index position (names are sorted)
+	 */
+	std::string name(unsigned int index) const;
+
+	/**
+	 * Location of entry by index position
+	 */
+	Pack::Entry entry(unsigned int index) const;
+
+	/**
+	 * Find entry by name
+	 * @return false if there is no such entry.
+	 */
+	bool find(const std::string &name, Pack::Entry &entry) const;
+
+	/**
+	 * Read entry data
+	 */
+	bool read(const Pack::Entry &entry, std::string &data) const;
+
+	/**
+	 * Find and read entry data
+	 */
+	bool read(const std::string &name, std::string &data) const;
+
+private:
+	PackReader(const PackReader &);
+
+	// Check that names of all records lie in string table and entries in data file
+	bool isValid(uint64_t data_length) const;
+
+	// Compare record name with name
+	int compare(const Pack::IndexRecord &record, const std::string &name) const;
+
+private:
+	// Data file descriptor
+	int m_fd;
+
+	// Mapped index
+	void *m_index;
+	size_t m_index_length;
+
+	// Index parts
+	const Pack::IndexHeader *m_header;
+	const Pack::IndexRecord *m_records;
+	const char *m_strings;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "PackStore.h"
+
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+
+const std::string PackStore::Scope::ALIAS = "alias";
+const std::string PackStore::Scope::RUN = "run";
+
+
+//-----------------------------------------------------------------------------
+PackStore::PackStore(const string &dest, const string &scope)
+	:m_dest(dest)
+	,m_scope(scope)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+PackStore::~PackStore()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+string PackStore::add(const string &alias, const string &name, 
+						const string &format, const string &data)
+{
+	string pack_name = m_scope == Scope::RUN ? "all" : alias;
+	string entry_name = m_scope == Scope::RUN ? alias + "/" + name : name;
+
+	WriterPtr writer;
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+
+		WriterPtr &found = m_writers[pack_name];
+		if (!found)
+		{
+			found.reset(new PackWriter(fs::absolute(fs::path(m_dest) / pack_name).native()));
+		}
+
+		writer = found;
+	}
+
+	writer->add(entry_name, format, data);
+
+	return writer->path() + Pack::DATA_EXTENSION + "#" + entry_name;
+}
+
+//-----------------------------------------------------------------------------
+void PackStore::close()
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	// Close every pack even if some index can not be written, report the first failure
+	string error;
+	for (map<string, WriterPtr>::iterator it = m_writers.begin(); it != m_writers.end(); ++it)
+	{
+		try
+		{
+			it->second->close();
+		}
+		catch (std::exception &ex)
+		{
+			if (error.empty())
+			{
+				error = ex.what();
+			}
+		}
+	}
+
+	if (!error.empty())
+	{
+		throw runtime_error(error);
+	}
+}
@@ -0,0 +1,86 @@
+
+#ifndef _PACK_STORE_H
+#define _PACK_STORE_H 
+
+#include "Pack.h"
+#include "PackWriter.h"
+
+#include <string>
+#include <map>
+
+#include <boost/smart_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+/**
+ * Set of packs receiving outputs of a run, either one pack per size alias 
+ * (<dest>/<alias>.pack, entry name is file name) or one pack for 
+ * the whole run (<dest>/all.pack, entry name is <alias>/<file name>).
+ * Thread safe.
+ */
+class PackStore
+{
+public:
+	/**
+	 * Pack scope
+	 */
+	class Scope
+	{
+	public:
+		// One pack per size alias
+		static const std::string ALIAS;
+
+		// One pack for all outputs
+		static const std::string RUN;
+	};
+
+public:
+	/**
+	 * Create store
+	 * @param dest Destination directory.
+	 * @param scope Pack scope.
+	 */
+	PackStore(const std::string &dest, const std::string &scope);
+
+	/**
+	 * Close all packs not closed yet, errors are ignored
+	 */
+	virtual ~PackStore();
+
+public:
+	/**
+	 * Add output
+	 * @param alias Size alias.
+	 * @param name File name.
+	 * @param format Encoding format.
+	 * @param data Encoded data.
+	 * @return Location string for contents: <pack path>.pack#<entry name>
+	 */
+	std::string add(const std::string &alias, const std::string &name, 
+					const std::string &format, const std::string &data);
+
+	/**
+	 * Close all packs writing their indexes
+	 * @throws std::runtime_error if some index can not be written.
+	 */
+	void close();
+
+private:
+	PackStore(const PackStore &);
+
+private:
+	typedef boost::shared_ptr<PackWriter> WriterPtr;
+
+	// Destination directory
+	std::string m_dest;
+
+	// Scope
+	std::string m_scope;
+
+	// Writers by pack name
+	std::map<std::string, WriterPtr> m_writers;
+
+	// Guards writers map
+	boost::mutex m_mutex;
+};
+
+#endif
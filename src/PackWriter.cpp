@@ -0,0 +1,177 @@
+#include "PackWriter.h"
+#include "PackReader.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+PackWriter::PackWriter(const string &path)
+	:m_path(path)
+	,m_fd(-1)
+	,m_size(0)
+{
+	string data_path = path + Pack::DATA_EXTENSION;
+	string index_path = path + Pack::INDEX_EXTENSION;
+
+	// Load index of existing pack
+	struct stat st;
+	if (stat(index_path.c_str(), &st) == 0)
+	{
+		PackReader reader(path);
+		for (unsigned int i = 0; i < reader.size(); ++i)
+		{
+			m_entries[reader.name(i)] = reader.entry(i);
+		}
+	}
+
+	m_fd = open(data_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (m_fd < 0)
+	{
+		throw runtime_error(string("Can not open pack ") + data_path);
+	}
+
+	if (fstat(m_fd, &st) == 0)
+	{
+		m_size = st.st_size;
+	}
+}
+
+//-----------------------------------------------------------------------------
+PackWriter::~PackWriter()
+{
+	try
+	{
+		close();
+	}
+	catch (...)
+	{
+	}
+}
+
+//-----------------------------------------------------------------------------
+Pack::Entry PackWriter::add(const string &name, const string &format, const string &data)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	if (m_fd < 0)
+	{
+		throw runtime_error(string("Pack is closed ") + m_path);
+	}
+
+	size_t done = 0;
+	while (done < data.size())
+	{
+		ssize_t count = write(m_fd, data.data() + done, data.size() - done);
+		if (count < 0 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if (count <= 0)
+		{
+			// Drop partial entry, offsets of next entries are computed from m_size, 
+			// so if it stays in file they are computed past it
+			int error = count < 0 ? errno : ENOSPC;
+			struct stat st;
+			if (ftruncate(m_fd, m_size) != 0 && fstat(m_fd, &st) == 0)
+			{
+				m_size = st.st_size;
+			}
+
+			throw runtime_error(string("Can not write pack ") + m_path + ": " + strerror(error));
+		}
+
+		done += count;
+	}
+
+	Pack::Entry entry;
+	entry.offset = m_size;
+	entry.length = data.size();
+	entry.format = format;
+
+	m_size += data.size();
+	m_entries[name] = entry;
+
+	return entry;
+}
+
+//-----------------------------------------------------------------------------
+void PackWriter::close()
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	if (m_fd < 0)
+	{
+		return;
+	}
+
+	::close(m_fd);
+	m_fd = -1;
+
+	writeIndex();
+}
+
+//-----------------------------------------------------------------------------
+const string PackWriter::path() const
+{
+	return m_path;
+}
+
+//-----------------------------------------------------------------------------
+void PackWriter::writeIndex()
+{
+	vector<Pack::IndexRecord> records;
+	string strings;
+
+	// Map is ordered by name, so records come out sorted
+	for (map<string, Pack::Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		Pack::IndexRecord record;
+		memset(&record, 0, sizeof(record));
+
+		record.name_offset = strings.size();
+		record.name_length = it->first.size();
+		strncpy(record.format, it->second.format.c_str(), sizeof(record.format) - 1);
+		record.offset = it->second.offset;
+		record.length = it->second.length;
+
+		records.push_back(record);
+		strings += it->first;
+	}
+
+	Pack::IndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, Pack::MAGIC, sizeof(Pack::MAGIC));
+	header.version = Pack::VERSION;
+	header.count = records.size();
+	header.strings_offset = sizeof(header) + records.size() * sizeof(Pack::IndexRecord);
+
+	// Write to temporary file and rename, so readers never see partial index
+	string index_path = m_path + Pack::INDEX_EXTENSION;
+	string tmp_path = index_path + ".tmp";
+
+	ofstream outs(tmp_path.c_str(), ios::out | ios::binary | ios::trunc);
+	outs.write((const char *)&header, sizeof(header));
+	if (!records.empty())
+	{
+		outs.write((const char *)&records[0], records.size() * sizeof(Pack::IndexRecord));
+	}
+	outs.write(strings.data(), strings.size());
+	outs.close();
+
+	if (!outs || rename(tmp_path.c_str(), index_path.c_str()) != 0)
+	{
+		throw runtime_error(string("Can not write pack index ") + index_path);
+	}
+}
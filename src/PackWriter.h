@@ -0,0 +1,78 @@
+
+#ifndef _PACK_WRITER_H
+#define _PACK_WRITER_H 
+
+#include "Pack.h"
+
+#include <string>
+#include <map>
+
+#include <boost/thread/mutex.hpp>
+
+/**
+ * Appends entries to pack data file and writes sorted index on close.
+ * Existing pack is extended, entries with the same name are replaced 
+ * in index (data stays in pack). Thread safe.
+ */
+class PackWriter
+{
+public:
+	/**
+	 * Open pack for appending
+	 * @param path Pack path without extension.
+	 * @throws std::runtime_error if pack can not be opened.
+	 */
+	PackWriter(const std::string &path);
+
+	/**
+	 * Close pack writing index if not closed yet, errors are ignored, 
+	 * call close() to get them
+	 */
+	virtual ~PackWriter();
+
+public:
+	/**
+	 * Append entry
+	 * @param name Entry name.
+	 * @param format Encoding format.
+	 * @param data Encoded data.
+	 * @return Location of entry.
+	 * @throws std::runtime_error on write failure.
+	 */
+	Pack::Entry add(const std::string &name, const std::string &format, const std::string &data);
+
+	/**
+	 * Write index and close data file. Called by destructor.
+	 * @throws std::runtime_error on write failure.
+	 */
+	void close();
+
+	/**
+	 * Pack path without extension
+	 */
+	const std::string path() const;
+
+private:
+	PackWriter(const PackWriter &);
+
+	// Write sorted index
+	void writeIndex();
+
+private:
+	// Pack path
+	std::string m_path;
+
+	// Data file descriptor
+	int m_fd;
+
+	// Current data file size
+	uint64_t m_size;
+
+	// Entries by name
+	std::map<std::string, Pack::Entry> m_entries;
+
+	// Guards data file and entries
+	boost::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,282 @@
+#include "ParallelismTuner.h"
+#include "ImageResizer.h"
+#include "MagickExceptionInfo.h"
+#include "Stats.h"
+
+#include <fstream>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include <unistd.h>
+
+#include <Magick++.h>
+#include <magick/api.h>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+
+// Minimal speedup for extra threads to be considered useful
+static const double MIN_SPEEDUP = 1.3;
+
+const std::string ParallelismTuner::Operation::SAMPLE = "sample";
+const std::string ParallelismTuner::Operation::SCALE = "scale";
+const std::string ParallelismTuner::Operation::RESIZE = "resize";
+
+
+//-----------------------------------------------------------------------------
+ParallelismTuner::ParallelismTuner(unsigned int cores)
+	:m_cores(max(1u, cores))
+	,m_operations(1, Operation::SCALE)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+ParallelismTuner::~ParallelismTuner()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+void ParallelismTuner::operations(const string &tier, const vector<Size> &sizes)
+{
+	// Sizes with filter are resized with it whatever the tier is
+	bool filtered = false;
+	bool unfiltered = sizes.empty();
+	for (int i = 0; i < sizes.size(); ++i)
+	{
+		if (sizes[i].filter().empty())
+		{
+			unfiltered = true;
+		}
+		else
+		{
+			filtered = true;
+		}
+	}
+
+	m_operations.clear();
+	if (unfiltered)
+	{
+		if (tier == ImageResizer::QualityTier::DRAFT)
+		{
+			m_operations.push_back(Operation::SAMPLE);
+		}
+		else if (tier == ImageResizer::QualityTier::HIGH)
+		{
+			m_operations.push_back(Operation::RESIZE);
+		}
+		else
+		{
+			m_operations.push_back(Operation::SCALE);
+		}
+	}
+
+	if (filtered && find(m_operations.begin(), m_operations.end(), Operation::RESIZE) == m_operations.end())
+	{
+		m_operations.push_back(Operation::RESIZE);
+	}
+}
+
+//-----------------------------------------------------------------------------
+bool ParallelismTuner::load(const string &path)
+{
+	ifstream ins(path.c_str());
+
+	string key;
+	unsigned int cores = 0;
+	if (!(ins >> key >> cores) || key != "cores" || cores != m_cores)
+	{
+		return false;
+	}
+
+	// Lines "<operation> <pixels> <threads>", curves of other operations are kept for save
+	map<string, Curve> profiles;
+	string operation;
+	double pixels;
+	unsigned int threads;
+	while (ins >> operation >> pixels >> threads)
+	{
+		profiles[operation].push_back(make_pair(pixels, max(1u, min(threads, m_cores))));
+	}
+
+	for (map<string, Curve>::iterator it = profiles.begin(); it != profiles.end(); ++it)
+	{
+		sort(it->second.begin(), it->second.end());
+	}
+
+	m_profiles = profiles;
+
+	for (int i = 0; i < m_operations.size(); ++i)
+	{
+		if (m_profiles.find(m_operations[i]) == m_profiles.end())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ParallelismTuner::save(const string &path) const
+{
+	fs::path parent = fs::path(path).parent_path();
+	if (!parent.empty())
+	{
+		fs::create_directories(parent);
+	}
+
+	ofstream outs(path.c_str(), ios::out | ios::trunc);
+	outs << "cores " << m_cores << "\n";
+
+	for (map<string, Curve>::const_iterator it = m_profiles.begin(); it != m_profiles.end(); ++it)
+	{
+		for (int i = 0; i < it->second.size(); ++i)
+		{
+			outs << it->first << " " << it->second[i].first << " " << it->second[i].second << "\n";
+		}
+	}
+
+	outs.flush();
+	return outs.good();
+}
+
+//-----------------------------------------------------------------------------
+void ParallelismTuner::calibrate()
+{
+	// 0.25, 1, 4 and 16 megapixel images
+	static const unsigned int SIDES[] = { 512, 1024, 2048, 4096 };
+
+	Stats::Timer timer("tune.calibrate");
+
+	for (int o = 0; o < m_operations.size(); ++o)
+	{
+		Curve &curve = m_profiles[m_operations[o]];
+		curve.clear();
+
+		for (int i = 0; i < sizeof(SIDES) / sizeof(SIDES[0]); ++i)
+		{
+			unsigned int width = SIDES[i];
+			unsigned int height = SIDES[i];
+
+			unsigned int threads = 1;
+			if (m_cores > 1)
+			{
+				double single = measure(m_operations[o], width, height, 1);
+				double multi = measure(m_operations[o], width, height, m_cores);
+				double speedup = multi > 0 ? single / multi : 1;
+
+				if (speedup >= MIN_SPEEDUP)
+				{
+					threads = max(1u, min(m_cores, (unsigned int)floor(speedup + 0.5)));
+				}
+			}
+
+			curve.push_back(make_pair((double)width * height, threads));
+		}
+	}
+
+	ImageResizer::threads(0);
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ParallelismTuner::threadsFor(unsigned int width, unsigned int height) const
+{
+	double pixels = (double)width * height;
+
+	// Use entry of the largest calibrated size not exceeding image size
+	unsigned int threads = 1;
+	for (int o = 0; o < m_operations.size(); ++o)
+	{
+		map<string, Curve>::const_iterator found = m_profiles.find(m_operations[o]);
+		if (found == m_profiles.end())
+		{
+			continue;
+		}
+
+		const Curve &curve = found->second;
+		for (int i = 0; i < curve.size() && curve[i].first <= pixels; ++i)
+		{
+			threads = max(threads, curve[i].second);
+		}
+	}
+
+	return threads;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ParallelismTuner::cores() const
+{
+	return m_cores;
+}
+
+//-----------------------------------------------------------------------------
+string ParallelismTuner::defaultProfilePath()
+{
+	char host[256] = { 0 };
+	gethostname(host, sizeof(host) - 1);
+
+	const char *home = getenv("HOME");
+	fs::path dir = fs::path(home ? home : ".") / ".phresizer";
+
+	return (dir / (string("tune-") + host)).native();
+}
+
+//-----------------------------------------------------------------------------
+double ParallelismTuner::measure(const string &operation, unsigned int width, unsigned int height, 
+									unsigned int threads) const
+{
+	ImageResizer::threads(threads);
+
+	Magick::Image image(Magick::Geometry(width, height), Magick::Color("gray"));
+
+	double best = 0;
+	for (int i = 0; i < 3; ++i)
+	{
+		double start = Stats::now();
+
+		// Resample into new image the way ImageResizerMagick does, 
+		// source stays shared and is not copied
+		MagickExceptionInfo exception;
+		MagickLib::Image *result = NULL;
+
+		if (operation == Operation::SAMPLE)
+		{
+			MagickLib::Image *sampled = MagickLib::SampleImage(image.constImage(), width * 2 / 3, height * 2 / 3, 
+																&exception.info);
+			if (sampled)
+			{
+				result = MagickLib::ScaleImage(sampled, width / 3, height / 3, &exception.info);
+				MagickLib::DestroyImage(sampled);
+			}
+		}
+		else if (operation == Operation::RESIZE)
+		{
+			result = MagickLib::ResizeImage(image.constImage(), width / 3, height / 3, Magick::LanczosFilter, 1.0, 
+											&exception.info);
+		}
+		else
+		{
+			result = MagickLib::ScaleImage(image.constImage(), width / 3, height / 3, &exception.info);
+		}
+
+		if (result)
+		{
+			MagickLib::DestroyImage(result);
+		}
+
+		double spent = Stats::now() - start;
+		if (i == 0 || spent < best)
+		{
+			best = spent;
+		}
+	}
+
+	return best;
+}
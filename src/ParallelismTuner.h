@@ -0,0 +1,110 @@
+
+#ifndef _PARALLELISM_TUNER_H
+#define _PARALLELISM_TUNER_H 
+
+#include "Size.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+/**
+ * Chooses how many threads one image should use inside GraphicsMagick 
+ * (per-image parallelism) given its pixel count. The rest of the cores 
+ * is left to other files processed in parallel (per-file parallelism).
+ *
+ * Choice is based on host profile: measured speedup of multi-threaded 
+ * resampling for several image sizes, one curve per resampling operation 
+ * (they scale with threads very differently). Profile is produced by 
+ * a short calibration run and cached in a file.
+ */
+class ParallelismTuner
+{
+public:
+	/**
+	 * Resampling operation
+	 */
+	class Operation
+	{
+	public:
+		// Point sampling followed by box averaging, draft tier
+		static const std::string SAMPLE;
+
+		// Box averaging, normal tier
+		static const std::string SCALE;
+
+		// Filtered resize, high tier and sizes with filter
+		static const std::string RESIZE;
+	};
+
+public:
+	/**
+	 * Create tuner
+	 * @param cores Count of cores available for processing.
+	 */
+	ParallelismTuner(unsigned int cores);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~ParallelismTuner();
+
+public:
+	/**
+	 * Set operations to profile from quality tier and sizes of run
+	 */
+	void operations(const std::string &tier, const std::vector<Size> &sizes);
+
+	/**
+	 * Load cached profile
+	 * @return false if file is missing, was made for different core count 
+	 * or has no curve for some operation of run.
+	 */
+	bool load(const std::string &path);
+
+	/**
+	 * Save profile
+	 */
+	bool save(const std::string &path) const;
+
+	/**
+	 * Measure multi-threaded speedup of operations of run for several image sizes
+	 */
+	void calibrate();
+
+	/**
+	 * Threads worth using for image of specified size, 
+	 * the most for any operation of run
+	 */
+	unsigned int threadsFor(unsigned int width, unsigned int height) const;
+
+	/**
+	 * Count of cores
+	 */
+	unsigned int cores() const;
+
+	/**
+	 * Default profile path for this host: $HOME/.phresizer/tune-<hostname>
+	 */
+	static std::string defaultProfilePath();
+
+private:
+	typedef std::vector<std::pair<double, unsigned int> > Curve;
+
+	// Time of resampling image with operation and thread count, best of several runs
+	double measure(const std::string &operation, unsigned int width, unsigned int height, 
+					unsigned int threads) const;
+
+private:
+	// Count of cores
+	unsigned int m_cores;
+
+	// Operations of run
+	std::vector<std::string> m_operations;
+
+	// Operation -> pixel count -> useful thread count, ordered by pixel count
+	std::map<std::string, Curve> m_profiles;
+};
+
+#endif
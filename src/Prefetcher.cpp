@@ -0,0 +1,207 @@
+#include "Prefetcher.h"
+#include "Stats.h"
+#include "Trace.h"
+
+#include <iomanip>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <boost/bind/bind.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+
+//-----------------------------------------------------------------------------
+Prefetcher::Prefetcher(const vector<fs::path> &files, unsigned int depth, size_t budget, bool buffer)
+	:m_files(files)
+	,m_depth(depth)
+	,m_budget(budget)
+	,m_buffer(buffer)
+	,m_position(0)
+	,m_consumed(0)
+	,m_bytes(0)
+	,m_hits(0)
+	,m_misses(0)
+	,m_stall_ms(0)
+	,m_stop(false)
+{
+	m_thread = boost::thread(boost::bind(&Prefetcher::run, this));
+}
+
+//-----------------------------------------------------------------------------
+Prefetcher::~Prefetcher()
+{
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_changed.notify_all();
+	m_thread.join();
+}
+
+//-----------------------------------------------------------------------------
+bool Prefetcher::take(size_t index, string &data)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	// Consumer overtook prefetcher, skip files being processed already
+	if (m_consumed < index + 1)
+	{
+		m_consumed = index + 1;
+	}
+
+	if (m_position < m_consumed)
+	{
+		m_position = m_consumed;
+	}
+
+	m_changed.notify_all();
+
+	map<size_t, Slot>::iterator it = m_slots.find(index);
+	if (it == m_slots.end())
+	{
+		m_misses++;
+		return false;
+	}
+
+	if (it->second.state == LOADING)
+	{
+		double start = Stats::now();
+		while (it->second.state == LOADING)
+		{
+			m_changed.wait(lock);
+		}
+
+		m_stall_ms += Stats::now() - start;
+	}
+
+	bool hit = it->second.state == READY;
+	if (hit)
+	{
+		m_hits++;
+		data.swap(it->second.data);
+	}
+	else
+	{
+		m_misses++;
+	}
+
+	m_bytes -= it->second.size;
+	m_slots.erase(it);
+	m_changed.notify_all();
+
+	return hit && m_buffer;
+}
+
+//-----------------------------------------------------------------------------
+void Prefetcher::print(ostream &output) const
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	unsigned long total = m_hits + m_misses;
+
+	output << "Prefetch (" << (m_buffer ? "buffer" : "advise") << "): " 
+			<< m_hits << " hits, " << m_misses << " misses, hit rate " 
+			<< fixed << setprecision(1) << (total ? 100.0 * m_hits / total : 0.0) << "%, "
+			<< "stall " << m_stall_ms << " ms\n";
+}
+
+//-----------------------------------------------------------------------------
+void Prefetcher::run()
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	while (!m_stop)
+	{
+		if (m_position >= m_files.size() || m_position >= m_consumed + m_depth)
+		{
+			m_changed.wait(lock);
+			continue;
+		}
+
+		size_t index = m_position;
+		string path = m_files[index].native();
+
+		boost::system::error_code error;
+		size_t size = fs::is_regular_file(path, error) ? fs::file_size(path, error) : 0;
+		if (error || size == 0)
+		{
+			m_position++;
+			continue;
+		}
+
+		// Keep within budget, but always allow one file so large files do not block
+		if (m_bytes > 0 && m_bytes + size > m_budget)
+		{
+			m_changed.wait(lock);
+			continue;
+		}
+
+		m_position++;
+		m_bytes += size;
+
+		Slot &slot = m_slots[index];
+		slot.state = LOADING;
+		slot.size = size;
+
+		lock.unlock();
+
+		string data;
+		bool fetched = fetch(path, size, data);
+
+		lock.lock();
+
+		Slot &loaded = m_slots[index];
+		loaded.state = fetched ? READY : FAILED;
+		loaded.data.swap(data);
+
+		m_changed.notify_all();
+	}
+}
+
+//-----------------------------------------------------------------------------
+bool Prefetcher::fetch(const string &path, size_t size, string &data)
+{
+	Trace::Span span("prefetch", "io");
+	span.arg("path", path);
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	bool result = true;
+	if (m_buffer)
+	{
+		data.resize(size);
+
+		size_t done = 0;
+		while (done < size)
+		{
+			ssize_t count = read(fd, &data[done], size - done);
+			if (count <= 0)
+			{
+				break;
+			}
+
+			done += count;
+		}
+
+		data.resize(done);
+		result = done == size;
+	}
+	else
+	{
+#ifdef POSIX_FADV_WILLNEED
+		result = posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED) == 0;
+#endif
+	}
+
+	close(fd);
+	return result;
+}
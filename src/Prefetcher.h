@@ -0,0 +1,125 @@
+
+#ifndef _PREFETCHER_H
+#define _PREFETCHER_H 
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ostream>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+/**
+ * Walks ahead of processing in the file list and warms up upcoming 
+ * source files, so decoding does not start with a cold read.
+ * 
+ * In advise mode posix_fadvise(WILLNEED) asks kernel to read file 
+ * into page cache asynchronously. In buffer mode files are read into 
+ * memory and handed over to the decoder. Both modes keep at most 
+ * depth files and budget bytes ahead of the consumer.
+ */
+class Prefetcher
+{
+public:
+	/**
+	 * Create prefetcher and start background thread
+	 * @param files File list in processing order.
+	 * @param depth Count of files to prefetch ahead.
+	 * @param budget Maximum bytes prefetched and not yet consumed.
+	 * @param buffer Read files into memory instead of advising kernel.
+	 */
+	Prefetcher(const std::vector<boost::filesystem::path> &files, 
+				unsigned int depth, size_t budget, bool buffer);
+
+	/**
+	 * Stop background thread
+	 */
+	virtual ~Prefetcher();
+
+public:
+	/**
+	 * Mark file as being processed and get its prefetched content. 
+	 * Waits if the file is being read right now.
+	 * @param index File index.
+	 * @param data File content in buffer mode.
+	 * @return true if content is returned (buffer mode hit).
+	 */
+	bool take(size_t index, std::string &data);
+
+	/**
+	 * Print hit rate and stall time
+	 */
+	void print(std::ostream &output) const;
+
+private:
+	Prefetcher(const Prefetcher &);
+
+	// Background thread body
+	void run();
+
+	// Warm up one file, returns false on failure
+	bool fetch(const std::string &path, size_t size, std::string &data);
+
+private:
+	// Slot state
+	enum State
+	{
+		LOADING,
+		READY,
+		FAILED
+	};
+
+	// Prefetched file
+	struct Slot
+	{
+		State state;
+		size_t size;
+		std::string data;
+	};
+
+	// Files
+	const std::vector<boost::filesystem::path> &m_files;
+
+	// Depth
+	unsigned int m_depth;
+
+	// Byte budget
+	size_t m_budget;
+
+	// Buffer mode
+	bool m_buffer;
+
+	// Next file to prefetch
+	size_t m_position;
+
+	// Files before this index are consumed
+	size_t m_consumed;
+
+	// Bytes prefetched and not consumed
+	size_t m_bytes;
+
+	// Prefetched files by index
+	std::map<size_t, Slot> m_slots;
+
+	// Counters
+	unsigned long m_hits;
+	unsigned long m_misses;
+	double m_stall_ms;
+
+	// Stop flag
+	bool m_stop;
+
+	// Guards state
+	mutable boost::mutex m_mutex;
+
+	// Signals state changes
+	boost::condition_variable m_changed;
+
+	// Background thread
+	boost::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,321 @@
+#include "Processor.h"
+#include "Hash.h"
+#include "Limits.h"
+#include "Metrics.h"
+#include "Stats.h"
+#include "Trace.h"
+
+#include <fstream>
+#include <utility>
+#include <stdint.h>
+
+#include <boost/filesystem.hpp>
+
+using namespace std;
+
+namespace fs = boost::filesystem;
+
+
+//-----------------------------------------------------------------------------
+Processor::Processor(const vector<Size> &sizes, const ResizeOptions &options)
+	:m_sizes(sizes)
+	,m_options(options)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Processor::~Processor()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Processor::OutputList Processor::resize(const string &file) const
+{
+	ImageResizer::AutoPtr resizer = create(file);
+	return resize(*resizer);
+}
+
+//-----------------------------------------------------------------------------
+Processor::OutputList Processor::resize(const void *data, size_t length) const
+{
+	ImageResizer::AutoPtr resizer = create(data, length);
+	return resize(*resizer);
+}
+
+//-----------------------------------------------------------------------------
+void Processor::prepare(const string &dest, bool packed) const
+{
+	fs::create_directories(dest);
+
+	for (int i = 0; i < m_sizes.size() && !packed; ++i)
+	{
+		// Make output path
+		fs::create_directories(fs::path(dest) / m_sizes[i].alias());
+	}
+
+	if (m_options.isMetaEnabled() && !packed)
+	{
+		// Make exif meta path
+		fs::create_directories(fs::path(dest) / "meta");
+	}
+
+	if (m_options.isContentsEnabled())
+	{
+		// Make contents path
+		fs::create_directories(fs::path(dest) / "contents");
+	}
+}
+
+//-----------------------------------------------------------------------------
+void Processor::process(const string &file, const string &dest, PackStore *packs) const
+{
+	// Create resizer
+	ImageResizer::AutoPtr resizer = create(file);
+
+	write(*resizer, fs::path(file).filename(), dest, packs);
+}
+
+//-----------------------------------------------------------------------------
+void Processor::process(const string &file, const void *data, size_t length, 
+						const string &dest, PackStore *packs) const
+{
+	// Master cache is keyed by file, buffered data is only used without it
+	ImageResizer::AutoPtr resizer = m_options.masterCache().empty() ? create(data, length) : create(file);
+
+	write(*resizer, fs::path(file).filename(), dest, packs);
+}
+
+//-----------------------------------------------------------------------------
+void Processor::processEntry(const string &name, const void *data, size_t length, 
+								const string &dest, PackStore *packs) const
+{
+	// Create resizer
+	ImageResizer::AutoPtr resizer = create(data, length);
+
+	write(*resizer, fs::path(name), dest, packs);
+}
+
+//-----------------------------------------------------------------------------
+void Processor::write(ImageResizer &resizer, const fs::path &name, 
+						const string &dest, PackStore *packs) const
+{
+	vector<string> contents;
+	double bytes = 0;
+
+	// Name inside output directories, with shard subdirectories if enabled
+	fs::path sharded = fs::path(shard(name.native())) / name;
+	bool flat = !sharded.has_parent_path();
+
+	// Files written so far, removed if file exceeds limits midway
+	vector<string> written;
+
+	// Pack entries can not be taken back, so they are added once all sizes are encoded
+	vector<pair<string, string> > blobs;
+
+	try
+	{
+		if (m_options.isMetaEnabled() && !packs)
+		{
+			fs::path meta_file = fs::path(dest) / "meta" / sharded;
+			string meta = fs::absolute(meta_file).replace_extension(".exif").native();
+
+			if (!flat)
+			{
+				fs::create_directories(fs::path(meta).parent_path());
+			}
+
+			// Add to contents
+			contents.push_back(string("meta=") + meta);
+
+			// Write exif info
+			written.push_back(meta);
+			resizer.writeExif(meta);
+		}
+
+		for (int i = 0; i < m_sizes.size() && packs; ++i)
+		{
+			string blob;
+			if (resizer.resizeToBlob(blob, m_sizes[i]))
+			{
+				blobs.push_back(make_pair(m_sizes[i].alias(), string()));
+				blobs.back().second.swap(blob);
+			}
+		}
+
+		for (int i = 0; i < m_sizes.size() && !packs; ++i)
+		{
+			fs::path out_path = fs::path(dest) / m_sizes[i].alias() / sharded;
+			string out = fs::absolute(out_path).native();
+
+			if (!flat)
+			{
+				fs::create_directories(out_path.parent_path());
+			}
+
+			// Add to contents
+			contents.push_back(m_sizes[i].alias() + "=" + out);
+
+			// Resize
+			written.push_back(out);
+			if (resizer.resize(out, m_sizes[i]) && Metrics::instance().isEnabled())
+			{
+				boost::system::error_code error;
+				uintmax_t size = fs::file_size(out, error);
+				bytes += error ? 0 : size;
+			}
+		}
+	}
+	catch (Limits::Exceeded &)
+	{
+		for (size_t i = 0; i < written.size(); ++i)
+		{
+			boost::system::error_code error;
+			fs::remove(written[i], error);
+		}
+
+		throw;
+	}
+
+	if (m_options.isMetaEnabled() && packs)
+	{
+		contents.push_back(string("meta=") + packs->add("meta", name.native(), "EXIF", resizer.exif()));
+	}
+
+	for (size_t i = 0; i < blobs.size(); ++i)
+	{
+		Trace::Span span("pack", "io");
+		string location = packs->add(blobs[i].first, name.native(), resizer.format(), blobs[i].second);
+		bytes += blobs[i].second.size();
+
+		// Add to contents
+		contents.push_back(blobs[i].first + "=" + location);
+	}
+
+	if (Metrics::instance().isEnabled())
+	{
+		Metrics::instance().output((double)resizer.width() * resizer.height(), bytes);
+	}
+
+	// Write contents
+	if (m_options.isContentsEnabled())
+	{
+		Trace::Span span("contents", "io");
+
+		fs::path contents_file = fs::absolute(fs::path(dest) / "contents" / sharded).replace_extension(".cnt");
+
+		if (!flat)
+		{
+			fs::create_directories(contents_file.parent_path());
+		}
+
+		ofstream cnt_fstream(contents_file.native().c_str(), ios::out);
+		for (int i = 0; i < contents.size(); ++i)
+		{
+			cnt_fstream << contents[i] << "\n";
+		}
+
+		cnt_fstream.flush();
+	}
+}
+
+//-----------------------------------------------------------------------------
+string Processor::shard(const string &name) const
+{
+	if (m_options.shardLevels() == 0)
+	{
+		return "";
+	}
+
+	// Fixed hash, so layout never changes with library versions
+	string digits = Hash::hex(Hash::fnv1a(name));
+
+	string result;
+	for (unsigned int level = 0; level < m_options.shardLevels(); ++level)
+	{
+		if (level)
+		{
+			result += "/";
+		}
+
+		result.append(digits, level * m_options.shardDigits(), m_options.shardDigits());
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+const vector<Size> &Processor::sizes() const
+{
+	return m_sizes;
+}
+
+//-----------------------------------------------------------------------------
+const ResizeOptions &Processor::options() const
+{
+	return m_options;
+}
+
+//-----------------------------------------------------------------------------
+ImageResizer::AutoPtr Processor::create(const string &file) const
+{
+	Trace::Span span("decode", "cpu");
+	span.arg("path", file);
+
+	ImageResizer::AutoPtr resizer = ImageResizer::create(file, m_options);
+
+	for (int i = 0; i < m_sizes.size() && !m_options.masterCache().empty(); ++i)
+	{
+		if (!resizer->covers(m_sizes[i]))
+		{
+			// Cached master is too small for some size, decode original
+			Stats::instance().add("master.fallback", 0);
+
+			ResizeOptions original(m_options);
+			original.masterCache("");
+
+			return ImageResizer::create(file, original);
+		}
+	}
+
+	return resizer;
+}
+
+//-----------------------------------------------------------------------------
+ImageResizer::AutoPtr Processor::create(const void *data, size_t length) const
+{
+	Trace::Span span("decode", "cpu");
+
+	return ImageResizer::create(data, length, m_options);
+}
+
+//-----------------------------------------------------------------------------
+Processor::OutputList Processor::resize(ImageResizer &resizer) const
+{
+	OutputList outputs;
+
+	for (int i = 0; i < m_sizes.size(); ++i)
+	{
+		Output output;
+		output.alias = m_sizes[i].alias();
+		output.format = resizer.format();
+
+		if (resizer.resizeToBlob(output.blob, m_sizes[i]))
+		{
+			outputs.push_back(output);
+		}
+	}
+
+	if (m_options.isMetaEnabled())
+	{
+		Output output;
+		output.alias = "meta";
+		output.format = "EXIF";
+		output.blob = resizer.exif();
+
+		outputs.push_back(output);
+	}
+
+	return outputs;
+}
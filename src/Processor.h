@@ -0,0 +1,155 @@
+
+#ifndef _PROCESSOR_H
+#define _PROCESSOR_H 
+
+#include "Size.h"
+#include "ResizeOptions.h"
+#include "ImageResizer.h"
+#include "PackStore.h"
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <boost/filesystem/path.hpp>
+
+/**
+ * Entry point of libphresizer. 
+ * Resizes one image to the configured list of sizes, either writing 
+ * outputs to destination directory layout used by the phresizer tool
+ * or returning encoded results in memory.
+ *
+ * Processor is immutable after construction, all methods are const and 
+ * may be called concurrently from multiple threads. Every call decodes 
+ * its own copy of the image. Errors are reported with exceptions derived 
+ * from std::exception.
+ */
+class Processor
+{
+public:
+	/**
+	 * Single encoded result
+	 */
+	struct Output
+	{
+		// Size alias, or "meta" for exif info
+		std::string alias;
+
+		// Encoding format, e.g. "JPEG", or "EXIF" for exif info
+		std::string format;
+
+		// Encoded data
+		std::string blob;
+	};
+
+	typedef std::vector<Output> OutputList;
+
+public:
+	/**
+	 * Create processor
+	 * @param sizes Size definitions.
+	 * @param options Resize options.
+	 */
+	Processor(const std::vector<Size> &sizes, const ResizeOptions &options);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~Processor();
+
+public:
+	/**
+	 * Resize image file to all sizes
+	 * @param file Source image path.
+	 * @return Encoded results in sizes order, exif info last if meta is enabled.
+	 */
+	OutputList resize(const std::string &file) const;
+
+	/**
+	 * Resize encoded image to all sizes
+	 * @param data Encoded source image.
+	 * @param length Length of data in bytes.
+	 * @return Encoded results in sizes order, exif info last if meta is enabled.
+	 */
+	OutputList resize(const void *data, size_t length) const;
+
+	/**
+	 * Create destination directory layout: 
+	 * <dest>/<alias>/ (unless packed), <dest>/meta/ and <dest>/contents/
+	 */
+	void prepare(const std::string &dest, bool packed = false) const;
+
+	/**
+	 * Resize image file into destination directory layout. 
+	 * Writes <dest>/<alias>/<shard>/<name> for every size, and if enabled 
+	 * <dest>/meta/<shard>/<name>.exif and <dest>/contents/<shard>/<name>.cnt
+	 * @param file Source image path.
+	 * @param dest Destination directory.
+	 * @param packs If not null, sizes and exif info are added to packs 
+	 *		instead of separate files.
+	 */
+	void process(const std::string &file, const std::string &dest, PackStore *packs = NULL) const;
+
+	/**
+	 * Resize image already read to memory into destination directory layout
+	 * @param file Source image path, used for output names.
+	 * @param data Encoded source image.
+	 * @param length Length of data in bytes.
+	 * @param dest Destination directory.
+	 * @param packs If not null, outputs are added to packs.
+	 */
+	void process(const std::string &file, const void *data, size_t length, 
+					const std::string &dest, PackStore *packs = NULL) const;
+
+	/**
+	 * Resize archive entry into destination directory layout. 
+	 * Unlike process() the whole relative name is kept, e.g. entry 
+	 * "2019/img.jpg" is written as <dest>/<alias>/<shard>/2019/img.jpg
+	 * @param name Archive relative name.
+	 * @param data Encoded source image.
+	 * @param length Length of data in bytes.
+	 * @param dest Destination directory.
+	 * @param packs If not null, outputs are added to packs.
+	 */
+	void processEntry(const std::string &name, const void *data, size_t length, 
+						const std::string &dest, PackStore *packs = NULL) const;
+
+	/**
+	 * Shard subdirectory of output name, e.g. "3f/a2", empty for flat layout. 
+	 * Derived from FNV-1a hash of name, so it is stable across runs and hosts.
+	 */
+	std::string shard(const std::string &name) const;
+
+	/**
+	 * Size definitions
+	 */
+	const std::vector<Size> &sizes() const;
+
+	/**
+	 * Resize options
+	 */
+	const ResizeOptions &options() const;
+
+private:
+	// Create resizer reading file
+	ImageResizer::AutoPtr create(const std::string &file) const;
+
+	// Create resizer reading memory
+	ImageResizer::AutoPtr create(const void *data, size_t length) const;
+
+	// Write outputs of prepared resizer into destination layout
+	void write(ImageResizer &resizer, const boost::filesystem::path &name, 
+				const std::string &dest, PackStore *packs) const;
+
+	// Resize with prepared resizer
+	OutputList resize(ImageResizer &resizer) const;
+
+private:
+	// Size definitions
+	std::vector<Size> m_sizes;
+
+	// Options
+	ResizeOptions m_options;
+};
+
+#endif
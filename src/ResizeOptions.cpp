@@ -0,0 +1,171 @@
+#include "ResizeOptions.h"
+#include "ImageResizer.h"
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+ResizeOptions::ResizeOptions()
+	:m_quality_tier(ImageResizer::QualityTier::NORMAL)
+	,m_pyramid(false)
+	,m_meta(false)
+	,m_contents(false)
+	,m_shard_levels(0)
+	,m_shard_digits(2)
+	,m_auto_orient(true)
+	,m_master_size(2048)
+	,m_max_pixels(0)
+	,m_decode_timeout(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+ResizeOptions::~ResizeOptions()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+const string ResizeOptions::sourceSize() const
+{
+	return m_source_size;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::sourceSize(const string &size)
+{
+	m_source_size = size;
+}
+
+//-----------------------------------------------------------------------------
+const string ResizeOptions::qualityTier() const
+{
+	return m_quality_tier;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::qualityTier(const string &tier)
+{
+	m_quality_tier = tier;
+}
+
+//-----------------------------------------------------------------------------
+bool ResizeOptions::isPyramidEnabled() const
+{
+	return m_pyramid;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::pyramidEnabled(bool enabled)
+{
+	m_pyramid = enabled;
+}
+
+//-----------------------------------------------------------------------------
+bool ResizeOptions::isMetaEnabled() const
+{
+	return m_meta;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::metaEnabled(bool enabled)
+{
+	m_meta = enabled;
+}
+
+//-----------------------------------------------------------------------------
+bool ResizeOptions::isContentsEnabled() const
+{
+	return m_contents;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::contentsEnabled(bool enabled)
+{
+	m_contents = enabled;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizeOptions::shardLevels() const
+{
+	return m_shard_levels;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::shardLevels(unsigned int levels)
+{
+	m_shard_levels = levels;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizeOptions::shardDigits() const
+{
+	return m_shard_digits;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::shardDigits(unsigned int digits)
+{
+	m_shard_digits = digits;
+}
+
+//-----------------------------------------------------------------------------
+bool ResizeOptions::isAutoOrientEnabled() const
+{
+	return m_auto_orient;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::autoOrientEnabled(bool enabled)
+{
+	m_auto_orient = enabled;
+}
+
+//-----------------------------------------------------------------------------
+const string ResizeOptions::masterCache() const
+{
+	return m_master_cache;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::masterCache(const string &dir)
+{
+	m_master_cache = dir;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizeOptions::masterSize() const
+{
+	return m_master_size;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::masterSize(unsigned int size)
+{
+	m_master_size = size;
+}
+
+//-----------------------------------------------------------------------------
+double ResizeOptions::maxPixels() const
+{
+	return m_max_pixels;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::maxPixels(double pixels)
+{
+	m_max_pixels = pixels;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizeOptions::decodeTimeout() const
+{
+	return m_decode_timeout;
+}
+
+//-----------------------------------------------------------------------------
+void ResizeOptions::decodeTimeout(unsigned int ms)
+{
+	m_decode_timeout = ms;
+}
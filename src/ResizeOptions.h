@@ -0,0 +1,138 @@
+
+#ifndef _RESIZE_OPTIONS_H
+#define _RESIZE_OPTIONS_H 
+
+#include <string>
+
+/**
+ * Options controlling how images are opened, resampled and 
+ * which additional outputs are produced. 
+ * Plain value object, safe to copy and share between threads.
+ */
+class ResizeOptions
+{
+public:
+	/**
+	 * Initialize with defaults: no source size hint, normal quality tier,
+	 * no pyramid, no meta and contents output, flat output directories, 
+	 * exif orientation applied, no master cache, no limits
+	 */
+	ResizeOptions();
+
+	/**
+	 * Destructor
+	 */
+	virtual ~ResizeOptions();
+
+public:
+	/**
+	 * Hint to open file at reduced size, e.g. "1024x1024"
+	 */
+	const std::string sourceSize() const;
+	void sourceSize(const std::string &size);
+
+	/**
+	 * Quality tier for sizes without explicit filter
+	 */
+	const std::string qualityTier() const;
+	void qualityTier(const std::string &tier);
+
+	/**
+	 * Build image pyramid to produce sizes
+	 */
+	bool isPyramidEnabled() const;
+	void pyramidEnabled(bool enabled);
+
+	/**
+	 * Extract EXIF meta information
+	 */
+	bool isMetaEnabled() const;
+	void metaEnabled(bool enabled);
+
+	/**
+	 * Write contents file listing produced outputs
+	 */
+	bool isContentsEnabled() const;
+	void contentsEnabled(bool enabled);
+
+	/**
+	 * Levels of hashed subdirectories outputs are spread over, 0 for flat layout
+	 */
+	unsigned int shardLevels() const;
+	void shardLevels(unsigned int levels);
+
+	/**
+	 * Hex digits of hash per shard level, fan-out is 16^digits
+	 */
+	unsigned int shardDigits() const;
+	void shardDigits(unsigned int digits);
+
+	/**
+	 * Apply exif orientation to results
+	 */
+	bool isAutoOrientEnabled() const;
+	void autoOrientEnabled(bool enabled);
+
+	/**
+	 * Directory of reduced resolution master cache, empty if disabled
+	 */
+	const std::string masterCache() const;
+	void masterCache(const std::string &dir);
+
+	/**
+	 * Long edge of cached masters in pixels
+	 */
+	unsigned int masterSize() const;
+	void masterSize(unsigned int size);
+
+	/**
+	 * Limit of pixels declared in image header, 0 for none
+	 */
+	double maxPixels() const;
+	void maxPixels(double pixels);
+
+	/**
+	 * Limit of decode time in milliseconds, 0 for none
+	 */
+	unsigned int decodeTimeout() const;
+	void decodeTimeout(unsigned int ms);
+
+private:
+	// Source size hint
+	std::string m_source_size;
+
+	// Quality tier
+	std::string m_quality_tier;
+
+	// Use pyramid
+	bool m_pyramid;
+
+	// Meta output
+	bool m_meta;
+
+	// Contents output
+	bool m_contents;
+
+	// Shard levels
+	unsigned int m_shard_levels;
+
+	// Hex digits per shard level
+	unsigned int m_shard_digits;
+
+	// Apply orientation
+	bool m_auto_orient;
+
+	// Master cache directory
+	std::string m_master_cache;
+
+	// Master long edge
+	unsigned int m_master_size;
+
+	// Declared pixels limit
+	double m_max_pixels;
+
+	// Decode time limit
+	unsigned int m_decode_timeout;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "ResizePlan.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+ResizePlan::ResizePlan(unsigned int width, unsigned int height, const Size &size)
+	:m_valid(false)
+	,m_source_width(width)
+	,m_source_height(height)
+	,m_scale_width(width)
+	,m_scale_height(height)
+	,m_width(width)
+	,m_height(height)
+	,m_offset_x(0)
+	,m_offset_y(0)
+{
+	if (!size.isValid() || width == 0 || height == 0)
+	{
+		return;
+	}
+
+	unsigned int box_width = size.width();
+	unsigned int box_height = size.height();
+
+	if (size.mode() == Size::ResizeMode::FIT)
+	{
+		fit(box_width, box_height);
+	}
+	else if (size.mode() == Size::ResizeMode::STRETCH)
+	{
+		// Only shrink images which do not fit into the box
+		if (width > box_width || height > box_height)
+		{
+			m_scale_width = box_width;
+			m_scale_height = box_height;
+		}
+	}
+	else if (size.mode() == Size::ResizeMode::PAD)
+	{
+		fit(box_width, box_height);
+
+		m_width = box_width;
+		m_height = box_height;
+		m_offset_x = (box_width - m_scale_width) / 2;
+		m_offset_y = (box_height - m_scale_height) / 2;
+		m_valid = true;
+		return;
+	}
+	else if (size.mode() == Size::ResizeMode::FILL_CROP)
+	{
+		double dx = (double)box_width / width;
+		double dy = (double)box_height / height;
+
+		if (dx > dy)
+		{
+			m_scale_width = box_width;
+			m_scale_height = max(box_height, (unsigned int)(height * dx));
+			m_offset_y = (m_scale_height - box_height) / 2;
+		}
+		else
+		{
+			m_scale_height = box_height;
+			m_scale_width = max(box_width, (unsigned int)(width * dy));
+			m_offset_x = (m_scale_width - box_width) / 2;
+		}
+
+		m_width = box_width;
+		m_height = box_height;
+		m_valid = true;
+		return;
+	}
+	else
+	{
+		return;
+	}
+
+	m_width = m_scale_width;
+	m_height = m_scale_height;
+	m_valid = true;
+}
+
+//-----------------------------------------------------------------------------
+bool ResizePlan::isValid() const
+{
+	return m_valid;
+}
+
+//-----------------------------------------------------------------------------
+bool ResizePlan::isResampled() const
+{
+	return m_scale_width != m_source_width || m_scale_height != m_source_height;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizePlan::scaleWidth() const
+{
+	return m_scale_width;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizePlan::scaleHeight() const
+{
+	return m_scale_height;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizePlan::width() const
+{
+	return m_width;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizePlan::height() const
+{
+	return m_height;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizePlan::offsetX() const
+{
+	return m_offset_x;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int ResizePlan::offsetY() const
+{
+	return m_offset_y;
+}
+
+//-----------------------------------------------------------------------------
+void ResizePlan::fit(unsigned int box_width, unsigned int box_height)
+{
+	// Only shrink images which do not fit into the box
+	if (m_source_width <= box_width && m_source_height <= box_height)
+	{
+		return;
+	}
+
+	double scale = min((double)box_width / m_source_width, 
+						(double)box_height / m_source_height);
+
+	m_scale_width = max(1u, (unsigned int)floor(scale * m_source_width + 0.5));
+	m_scale_height = max(1u, (unsigned int)floor(scale * m_source_height + 0.5));
+}
@@ -0,0 +1,92 @@
+
+#ifndef _RESIZE_PLAN_H
+#define _RESIZE_PLAN_H 
+
+#include "Size.h"
+
+/**
+ * Computes geometry of resize operation for given source dimensions.
+ * Plan is independent of image library and describes two steps:
+ * resampling of source to scale dimensions, then cropping (crop mode) 
+ * or centering on background canvas (pad mode) to output dimensions.
+ */
+class ResizePlan
+{
+public:
+	/**
+	 * Make plan
+	 * @param width Source width.
+	 * @param height Source height.
+	 * @param size Resizing parameters.
+	 */
+	ResizePlan(unsigned int width, unsigned int height, const Size &size);
+
+public:
+	/**
+	 * Is plan valid (known mode, positive dimensions)
+	 */
+	bool isValid() const;
+
+	/**
+	 * Is source resampled (scale dimensions differ from source)
+	 */
+	bool isResampled() const;
+
+	/**
+	 * Width source is resampled to
+	 */
+	unsigned int scaleWidth() const;
+
+	/**
+	 * Height source is resampled to
+	 */
+	unsigned int scaleHeight() const;
+
+	/**
+	 * Output width
+	 */
+	unsigned int width() const;
+
+	/**
+	 * Output height
+	 */
+	unsigned int height() const;
+
+	/**
+	 * Horizontal offset of crop window (crop mode) 
+	 * or of resampled image on canvas (pad mode)
+	 */
+	unsigned int offsetX() const;
+
+	/**
+	 * Vertical offset of crop window (crop mode) 
+	 * or of resampled image on canvas (pad mode)
+	 */
+	unsigned int offsetY() const;
+
+private:
+	// Fit source into box preserving aspect ratio, never enlarge
+	void fit(unsigned int box_width, unsigned int box_height);
+
+private:
+	// Validity
+	bool m_valid;
+
+	// Source dimensions
+	unsigned int m_source_width;
+	unsigned int m_source_height;
+
+	// Resampled dimensions
+	unsigned int m_scale_width;
+	unsigned int m_scale_height;
+
+	// Output dimensions
+	unsigned int m_width;
+	unsigned int m_height;
+
+	// Crop or pad offset
+	unsigned int m_offset_x;
+	unsigned int m_offset_y;
+};
+
+#endif
@@ -15,19 +15,30 @@ const std::string Size::ResizeMode::STRETCH = "stretch";
 const std::string Size::ResizeMode::PAD = "pad";
 const std::string Size::ResizeMode::FILL_CROP = "crop";
 
+const std::string Size::Filter::BOX = "box";
+const std::string Size::Filter::TRIANGLE = "triangle";
+const std::string Size::Filter::CATROM = "catrom";
+const std::string Size::Filter::LANCZOS = "lanczos";
+
 
 //-----------------------------------------------------------------------------
 Size::Size()
-	:m_mode(ResizeMode::FIT)
+	:m_width(0)
+	,m_height(0)
+	,m_mode(ResizeMode::FIT)
 	,m_background("#ffffff")
+	,m_use_previous(false)
 {
 
 }
 
 //-----------------------------------------------------------------------------
 Size::Size(const string &spec)
-	:m_mode(ResizeMode::FIT)
+	:m_width(0)
+	,m_height(0)
+	,m_mode(ResizeMode::FIT)
 	,m_background("#ffffff")
+	,m_use_previous(false)
 {
 	vector<string> params;
 	alg::split(params, spec, alg::is_any_of(","));
@@ -61,6 +72,10 @@ Size::Size(const string &spec)
 		{
 			m_use_previous = value == "true";
 		}
+		else if (key == "f")
+		{
+			m_filter = value;
+		}
 		else if (key == "s")
 		{
 			if (m_alias.empty())
@@ -141,6 +156,12 @@ bool Size::usePrevious() const
 	return m_use_previous;
 }
 
+//-----------------------------------------------------------------------------
+const string Size::filter() const
+{
+	return m_filter;
+}
+
 //-----------------------------------------------------------------------------
 void Size::copy(const Size &other)
 {
@@ -149,6 +170,8 @@ void Size::copy(const Size &other)
 	m_mode = other.mode();
 	m_alias = other.alias();
 	m_background = other.background();
+	m_use_previous = other.usePrevious();
+	m_filter = other.filter();
 }
 
 //-----------------------------------------------------------------------------
@@ -168,5 +191,6 @@ ostream &operator <<(ostream &output, const Size &size)
 			std::string("a:") << size.alias() << "," <<	
 			std::string("m:") << size.mode() << "," <<
 			std::string("b:") << size.background() << "," <<
+			std::string("f:") << size.filter() << "," <<
 			std::string("s:") << size.width() << "," << size.height();
 }
@@ -42,6 +42,25 @@ public:
 		static const std::string FILL_CROP;
 	};
 
+	/**
+	 * Resampling filter
+	 */
+	class Filter
+	{
+	public:
+		// Box (averaging) filter. Fastest, good enough for tiny thumbnails.
+		static const std::string BOX;
+
+		// Triangle (bilinear) filter.
+		static const std::string TRIANGLE;
+
+		// Catmull-Rom cubic filter. Sharp result at moderate cost.
+		static const std::string CATROM;
+
+		// Lanczos windowed sinc filter. Best quality, slowest.
+		static const std::string LANCZOS;
+	};
+
 public:
 	/**
 	 * Initialize with default params:
@@ -54,10 +73,12 @@ public:
 	/**
 	 * Constructor
 	 * @param spec String specification. Specification format:
-	 *		[a:<alias>,][m:fit|stretch|pad|crop,][b:<bgcolor>,][u:true|false,]s:<width>x<height>
+	 *		[a:<alias>,][m:fit|stretch|pad|crop,][b:<bgcolor>,][u:true|false,]
+	 *		[f:box|triangle|catrom|lanczos,]s:<width>x<height>
 	 *
 	 *		Where: a - alias, m - resize mode, b - background, 
-	 *				u - use previous size as source, s - size 
+	 *				u - use previous size as source, f - resampling filter, 
+	 *				s - size 
 	 */
 	Size(const std::string &spec);
 
@@ -112,6 +133,11 @@ public:
 	 */
 	bool usePrevious() const;
 
+	/**
+	 * Resampling filter, empty if quality tier default should be used
+	 */
+	const std::string filter() const;
+
 private:
 	// Copy values from another instance
 	void copy(const Size &other);
@@ -141,6 +167,9 @@ private:
 
 	// Use previous size as source
 	bool m_use_previous;
+
+	// Resampling filter
+	std::string m_filter;
 };
 
 #endif
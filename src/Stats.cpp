@@ -0,0 +1,136 @@
+#include "Stats.h"
+
+#include <iomanip>
+#include <algorithm>
+#include <sys/time.h>
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+Stats::Timer::Timer(const string &name, double pixels)
+	:m_name(name)
+	,m_pixels(pixels)
+	,m_start(Stats::now())
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Stats::Timer::~Timer()
+{
+	Stats::instance().add(m_name, Stats::now() - m_start, m_pixels);
+}
+
+//-----------------------------------------------------------------------------
+Stats::Entry::Entry()
+	:count(0)
+	,ms(0)
+	,pixels(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Stats::Peak::Peak()
+	:count(0)
+	,sum(0)
+	,max(0)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Stats &Stats::instance()
+{
+	static Stats stats;
+	return stats;
+}
+
+//-----------------------------------------------------------------------------
+double Stats::now()
+{
+	timeval tim;
+	gettimeofday(&tim, NULL);
+
+	return tim.tv_sec * 1000.0 + (tim.tv_usec / 1000.0);
+}
+
+//-----------------------------------------------------------------------------
+void Stats::add(const string &name, double ms, double pixels)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	Entry &entry = m_entries[name];
+	entry.count++;
+	entry.ms += ms;
+	entry.pixels += pixels;
+}
+
+//-----------------------------------------------------------------------------
+void Stats::peak(const string &name, double value)
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	Peak &peak = m_peaks[name];
+	peak.count++;
+	peak.sum += value;
+	peak.max = max(peak.max, value);
+}
+
+//-----------------------------------------------------------------------------
+void Stats::print(ostream &output) const
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	output << "Stats:\n";
+	output << setw(32) << left << "operation" 
+			<< setw(10) << right << "count" 
+			<< setw(12) << "total ms" 
+			<< setw(10) << "avg ms" 
+			<< setw(10) << "ms/MP" << "\n";
+
+	for (map<string, Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		const Entry &entry = it->second;
+		double mp = entry.pixels / 1000000.0;
+
+		output << setw(32) << left << it->first 
+				<< setw(10) << right << entry.count
+				<< fixed << setprecision(1)
+				<< setw(12) << entry.ms
+				<< setw(10) << (entry.count ? entry.ms / entry.count : 0.0);
+
+		if (mp > 0)
+		{
+			output << setw(10) << entry.ms / mp;
+		}
+		else
+		{
+			output << setw(10) << "-";
+		}
+
+		output << "\n";
+	}
+
+	if (m_peaks.empty())
+	{
+		return;
+	}
+
+	output << setw(32) << left << "value" 
+			<< setw(10) << right << "count" 
+			<< setw(12) << "avg" 
+			<< setw(10) << "max" << "\n";
+
+	for (map<string, Peak>::const_iterator it = m_peaks.begin(); it != m_peaks.end(); ++it)
+	{
+		const Peak &peak = it->second;
+
+		output << setw(32) << left << it->first 
+				<< setw(10) << right << peak.count
+				<< fixed << setprecision(1)
+				<< setw(12) << (peak.count ? peak.sum / peak.count : 0.0)
+				<< setw(10) << peak.max << "\n";
+	}
+}
@@ -0,0 +1,123 @@
+
+#ifndef _STATS_H
+#define _STATS_H 
+
+#include <string>
+#include <map>
+#include <ostream>
+
+#include <boost/thread/mutex.hpp>
+
+/**
+ * Collects cost statistics of named operations 
+ * (e.g. resampling with different quality tiers). Thread safe.
+ */
+class Stats
+{
+public:
+	/**
+	 * Measures time between construction and destruction 
+	 * and adds it to statistics
+	 */
+	class Timer
+	{
+	public:
+		/**
+		 * Start measurement
+		 * @param name Operation name.
+		 * @param pixels Count of processed pixels.
+		 */
+		Timer(const std::string &name, double pixels = 0);
+
+		/**
+		 * Stop measurement and store result
+		 */
+		~Timer();
+
+	private:
+		Timer(const Timer &);
+
+	private:
+		// Operation name
+		std::string m_name;
+
+		// Processed pixels
+		double m_pixels;
+
+		// Start time
+		double m_start;
+	};
+
+public:
+	/**
+	 * Get global statistics instance
+	 */
+	static Stats &instance();
+
+	/**
+	 * Current time in milliseconds
+	 */
+	static double now();
+
+	/**
+	 * Add operation cost
+	 * @param name Operation name.
+	 * @param ms Time spent in milliseconds.
+	 * @param pixels Count of processed pixels.
+	 */
+	void add(const std::string &name, double ms, double pixels = 0);
+
+	/**
+	 * Add sample of value whose maximum matters, e.g. memory per file
+	 * @param name Value name.
+	 * @param value Sample.
+	 */
+	void peak(const std::string &name, double value);
+
+	/**
+	 * Print collected statistics
+	 */
+	void print(std::ostream &output) const;
+
+private:
+	// Operation cost
+	struct Entry
+	{
+		Entry();
+
+		// Count of operations
+		unsigned long count;
+
+		// Total time in milliseconds
+		double ms;
+
+		// Total processed pixels
+		double pixels;
+	};
+
+	// Sampled value
+	struct Peak
+	{
+		Peak();
+
+		// Count of samples
+		unsigned long count;
+
+		// Sum of samples
+		double sum;
+
+		// Largest sample
+		double max;
+	};
+
+	// Entries by operation name
+	std::map<std::string, Entry> m_entries;
+
+	// Peaks by value name
+	std::map<std::string, Peak> m_peaks;
+
+	// Guards entries
+	mutable boost::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "TarReader.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+
+
+// Tar block size
+static const size_t BLOCK = 512;
+
+// Entries larger than this are not read into memory
+static const unsigned long long MAX_ENTRY = 1ULL << 31;
+
+// Extended headers larger than this are treated as corrupt
+static const unsigned long long MAX_HEADER = 1ULL << 20;
+
+// Chunk used to skip over unwanted entries
+static const size_t SKIP_CHUNK = 64 * 1024;
+
+
+//-----------------------------------------------------------------------------
+TarReader::TarReader(const string &path)
+	:m_path(path)
+	,m_file(gzopen(path.c_str(), "rb"))
+{
+	if (!m_file)
+	{
+		throw runtime_error(string("Can not open archive ") + path);
+	}
+
+	gzbuffer(m_file, 256 * 1024);
+}
+
+//-----------------------------------------------------------------------------
+TarReader::~TarReader()
+{
+	gzclose(m_file);
+}
+
+//-----------------------------------------------------------------------------
+bool TarReader::next(string &name, string &data)
+{
+	string long_name;
+
+	char header[BLOCK];
+	while (read(header, BLOCK))
+	{
+		// Archive ends with zero blocks
+		if (header[0] == 0)
+		{
+			return false;
+		}
+
+		unsigned long long size = number(header + 124, 12);
+		char type = header[156];
+
+		if ((type == 'L' || type == 'x') && size > MAX_HEADER)
+		{
+			throw runtime_error(string("Corrupt extended header in archive ") + m_path);
+		}
+
+		if (type == 'L')
+		{
+			// GNU long name of the following entry
+			content(size, long_name);
+			long_name = long_name.c_str();
+			continue;
+		}
+
+		if (type == 'x')
+		{
+			// Pax extended header, only path is used
+			string records;
+			content(size, records);
+
+			istringstream ins(records);
+			string record;
+			while (getline(ins, record))
+			{
+				size_t key = record.find(" path=");
+				if (key != string::npos)
+				{
+					long_name = record.substr(key + 6);
+				}
+			}
+
+			continue;
+		}
+
+		string entry;
+		if (!long_name.empty())
+		{
+			entry = long_name;
+			long_name.clear();
+		}
+		else
+		{
+			// Ustar splits long names to prefix and name
+			string prefix(header + 345, strnlen(header + 345, 155));
+			entry = string(header, strnlen(header, 100));
+
+			if (string(header + 257, 5) == "ustar" && !prefix.empty())
+			{
+				entry = prefix + "/" + entry;
+			}
+		}
+
+		// Directories and links are skipped silently, content is never read into memory
+		string original = entry;
+		if (type != '0' && type != '\0' && type != '7')
+		{
+			discard(size);
+			continue;
+		}
+
+		if (!sanitize(entry))
+		{
+			skip(original, "unsafe name");
+			discard(size);
+			continue;
+		}
+
+		if (size > MAX_ENTRY)
+		{
+			skip(entry, "larger than 2 GB");
+			discard(size);
+			continue;
+		}
+
+		name = entry;
+		content(size, data);
+
+		return true;
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+bool TarReader::read(char *buffer, size_t length)
+{
+	size_t done = 0;
+	while (done < length)
+	{
+		int count = gzread(m_file, buffer + done, length - done);
+		if (count < 0)
+		{
+			throw runtime_error(string("Can not read archive ") + m_path);
+		}
+
+		if (count == 0)
+		{
+			break;
+		}
+
+		done += count;
+	}
+
+	if (done != 0 && done != length)
+	{
+		throw runtime_error(string("Truncated archive ") + m_path);
+	}
+
+	return done == length;
+}
+
+//-----------------------------------------------------------------------------
+void TarReader::content(size_t size, string &data)
+{
+	size_t padded = (size + BLOCK - 1) / BLOCK * BLOCK;
+
+	data.resize(padded);
+	if (padded && !read(&data[0], padded))
+	{
+		throw runtime_error(string("Truncated archive ") + m_path);
+	}
+
+	data.resize(size);
+}
+
+//-----------------------------------------------------------------------------
+void TarReader::discard(unsigned long long size)
+{
+	unsigned long long padded = (size + BLOCK - 1) / BLOCK * BLOCK;
+
+	char buffer[SKIP_CHUNK];
+	while (padded > 0)
+	{
+		size_t chunk = (size_t)min<unsigned long long>(padded, SKIP_CHUNK);
+		if (!read(buffer, chunk))
+		{
+			throw runtime_error(string("Truncated archive ") + m_path);
+		}
+
+		padded -= chunk;
+	}
+}
+
+//-----------------------------------------------------------------------------
+unsigned long long TarReader::number(const char *field, size_t length)
+{
+	unsigned long long value = 0;
+
+	// GNU base-256 encoding of large values
+	if ((unsigned char)field[0] & 0x80)
+	{
+		value = (unsigned char)field[0] & 0x7f;
+		for (size_t i = 1; i < length; ++i)
+		{
+			value = (value << 8) | (unsigned char)field[i];
+		}
+
+		return value;
+	}
+
+	for (size_t i = 0; i < length && field[i]; ++i)
+	{
+		if (field[i] >= '0' && field[i] <= '7')
+		{
+			value = value * 8 + (field[i] - '0');
+		}
+	}
+
+	return value;
+}
@@ -0,0 +1,57 @@
+#ifndef _TAR_READER_H
+#define _TAR_READER_H 
+
+#include "ArchiveReader.h"
+
+#include <string>
+
+#include <zlib.h>
+
+/**
+ * Reader of ustar/GNU/pax tar archives, plain or gzip compressed. 
+ * Archive is read strictly sequentially, so it may be as large as needed.
+ */
+class TarReader
+	:public ArchiveReader
+{
+public:
+	/**
+	 * Open archive
+	 */
+	TarReader(const std::string &path);
+
+	/**
+	 * Close archive
+	 */
+	virtual ~TarReader();
+
+public:
+	/**
+	 * Read next regular file entry
+	 */
+	virtual bool next(std::string &name, std::string &data);
+
+private:
+	TarReader(const TarReader &);
+
+	// Read exactly length bytes, false at end of archive
+	bool read(char *buffer, size_t length);
+
+	// Read entry content and skip block padding
+	void content(size_t size, std::string &data);
+
+	// Skip entry content and block padding in fixed size chunks
+	void discard(unsigned long long size);
+
+	// Parse octal or base-256 numeric header field
+	static unsigned long long number(const char *field, size_t length);
+
+private:
+	// Archive path
+	std::string m_path;
+
+	// Archive stream, transparently decompressed
+	gzFile m_file;
+};
+
+#endif
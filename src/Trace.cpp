@@ -0,0 +1,177 @@
+#include "Trace.h"
+#include "Metrics.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+
+//-----------------------------------------------------------------------------
+Trace::Span::Span(const char *name, const char *category)
+	:m_enabled(Trace::instance().isEnabled())
+	,m_observed(Metrics::instance().isEnabled())
+	,m_name(name)
+	,m_category(category)
+	,m_start(0)
+{
+	if (m_enabled || m_observed)
+	{
+		m_start = Trace::now();
+	}
+}
+
+//-----------------------------------------------------------------------------
+Trace::Span::~Span()
+{
+	if (!m_enabled && !m_observed)
+	{
+		return;
+	}
+
+	double end = Trace::now();
+
+	if (m_enabled)
+	{
+		Trace::instance().add(m_name, m_category, m_start, end - m_start, Trace::threadId(), m_args);
+	}
+
+	if (m_observed)
+	{
+		Metrics::instance().observe(m_name, (end - m_start) / 1000000.0);
+	}
+}
+
+//-----------------------------------------------------------------------------
+void Trace::Span::arg(const char *name, const string &value)
+{
+	if (m_enabled)
+	{
+		m_args.push_back(make_pair(name, value));
+	}
+}
+
+//-----------------------------------------------------------------------------
+Trace::Trace()
+	:m_enabled(false)
+{
+
+}
+
+//-----------------------------------------------------------------------------
+Trace &Trace::instance()
+{
+	static Trace trace;
+	return trace;
+}
+
+//-----------------------------------------------------------------------------
+void Trace::enable()
+{
+	m_enabled = true;
+}
+
+//-----------------------------------------------------------------------------
+bool Trace::isEnabled() const
+{
+	return m_enabled;
+}
+
+//-----------------------------------------------------------------------------
+bool Trace::write(const string &path) const
+{
+	boost::mutex::scoped_lock lock(m_mutex);
+
+	ofstream outs(path.c_str(), ios::out | ios::trunc);
+
+	outs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	outs << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getpid() 
+			<< ",\"args\":{\"name\":\"phresizer\"}}";
+
+	for (int i = 0; i < m_events.size(); ++i)
+	{
+		outs << ",\n" << m_events[i];
+	}
+
+	outs << "\n]}\n";
+	outs.flush();
+
+	return outs.good();
+}
+
+//-----------------------------------------------------------------------------
+double Trace::now()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+
+//-----------------------------------------------------------------------------
+long Trace::threadId()
+{
+	return syscall(SYS_gettid);
+}
+
+//-----------------------------------------------------------------------------
+string Trace::escape(const string &value)
+{
+	string result;
+	for (int i = 0; i < value.size(); ++i)
+	{
+		unsigned char c = value[i];
+		if (c == '"' || c == '\\')
+		{
+			result += '\\';
+			result += c;
+		}
+		else if (c < 0x20)
+		{
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			result += buf;
+		}
+		else
+		{
+			result += c;
+		}
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+void Trace::add(const char *name, const char *category, double start, double duration, 
+				long tid, const vector<pair<const char *, string> > &args)
+{
+	ostringstream event;
+	event << fixed << setprecision(1)
+			<< "{\"name\":\"" << escape(name) 
+			<< "\",\"cat\":\"" << escape(category)
+			<< "\",\"ph\":\"X\",\"ts\":" << start 
+			<< ",\"dur\":" << duration 
+			<< ",\"pid\":" << getpid() 
+			<< ",\"tid\":" << tid;
+
+	if (!args.empty())
+	{
+		event << ",\"args\":{";
+		for (int i = 0; i < args.size(); ++i)
+		{
+			event << (i ? "," : "") << "\"" << escape(args[i].first) << "\":\"" << escape(args[i].second) << "\"";
+		}
+		event << "}";
+	}
+
+	event << "}";
+
+	boost::mutex::scoped_lock lock(m_mutex);
+	m_events.push_back(event.str());
+}
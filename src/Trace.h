@@ -0,0 +1,116 @@
+
+#ifndef _TRACE_H
+#define _TRACE_H 
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <boost/thread/mutex.hpp>
+
+/**
+ * Records timeline of operations per thread and writes it as 
+ * Chrome trace event JSON, which can be loaded in chrome://tracing 
+ * or Perfetto. Recording is off by default and disabled spans 
+ * cost a single flag check. Spans also feed stage latency histograms 
+ * of Metrics when metrics are enabled. Thread safe.
+ */
+class Trace
+{
+public:
+	/**
+	 * Records one span from construction to destruction
+	 */
+	class Span
+	{
+	public:
+		/**
+		 * Begin span
+		 * @param name Span name, e.g. "decode".
+		 * @param category Span category, e.g. "io".
+		 */
+		Span(const char *name, const char *category);
+
+		/**
+		 * End span
+		 */
+		~Span();
+
+		/**
+		 * Attach argument shown in trace viewer
+		 */
+		void arg(const char *name, const std::string &value);
+
+	private:
+		Span(const Span &);
+
+	private:
+		// Is trace enabled at span begin
+		bool m_enabled;
+
+		// Are metrics enabled at span begin
+		bool m_observed;
+
+		// Name
+		const char *m_name;
+
+		// Category
+		const char *m_category;
+
+		// Start time in microseconds
+		double m_start;
+
+		// Arguments
+		std::vector<std::pair<const char *, std::string> > m_args;
+	};
+
+public:
+	/**
+	 * Get global trace instance
+	 */
+	static Trace &instance();
+
+	/**
+	 * Start recording
+	 */
+	void enable();
+
+	/**
+	 * Is recording
+	 */
+	bool isEnabled() const;
+
+	/**
+	 * Write recorded events to file
+	 * @return false if file can not be written.
+	 */
+	bool write(const std::string &path) const;
+
+private:
+	Trace();
+
+	// Current time in microseconds
+	static double now();
+
+	// Current thread id
+	static long threadId();
+
+	// Escape string for JSON
+	static std::string escape(const std::string &value);
+
+	// Add complete event
+	void add(const char *name, const char *category, double start, double duration, 
+				long tid, const std::vector<std::pair<const char *, std::string> > &args);
+
+private:
+	// Recording flag
+	volatile bool m_enabled;
+
+	// Serialized events
+	std::vector<std::string> m_events;
+
+	// Guards events
+	mutable boost::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,341 @@
+#include "ZipReader.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <sstream>
+
+#include <zlib.h>
+
+using namespace std;
+
+
+// Record signatures
+static const uint32_t LOCAL_HEADER = 0x04034b50;
+static const uint32_t CENTRAL_HEADER = 0x02014b50;
+static const uint32_t END_OF_DIRECTORY = 0x06054b50;
+static const uint32_t ZIP64_END_OF_DIRECTORY = 0x06064b50;
+static const uint32_t ZIP64_LOCATOR = 0x07064b50;
+
+// End of central directory record size without comment, comment is at most 64 KB
+static const size_t END_SIZE = 22;
+static const size_t MAX_COMMENT = 0xffff;
+
+// Entries larger than this are not read into memory
+static const uint64_t MAX_ENTRY = 1ULL << 31;
+
+
+//-----------------------------------------------------------------------------
+ZipReader::ZipReader(const string &path)
+	:m_path(path)
+	,m_file(path.c_str(), ios::in | ios::binary)
+	,m_dir_offset(0)
+	,m_next(0)
+{
+	if (!m_file)
+	{
+		throw runtime_error(string("Can not open archive ") + path);
+	}
+
+	directory();
+}
+
+//-----------------------------------------------------------------------------
+ZipReader::~ZipReader()
+{
+
+}
+
+//-----------------------------------------------------------------------------
+bool ZipReader::Entry::operator<(const Entry &other) const
+{
+	return offset < other.offset;
+}
+
+//-----------------------------------------------------------------------------
+bool ZipReader::next(string &name, string &data)
+{
+	// Entries are located by central directory, so a corrupt entry 
+	// is skipped and the ones after it are still read
+	while (m_next < m_entries.size())
+	{
+		const Entry &entry = m_entries[m_next++];
+
+		char header[30];
+		read(entry.offset, header, sizeof(header));
+		if (u32(header) != LOCAL_HEADER)
+		{
+			skip(entry.name, "corrupt local header");
+			continue;
+		}
+
+		// Local extra field may differ from central one
+		uint64_t start = entry.offset + sizeof(header) + u16(header + 26) + u16(header + 28);
+		if (start > m_dir_offset || entry.compressed > m_dir_offset - start)
+		{
+			skip(entry.name, "corrupt local header");
+			continue;
+		}
+
+		string compressed((size_t)entry.compressed, '\0');
+		if (entry.compressed)
+		{
+			read(start, &compressed[0], compressed.size());
+		}
+
+		if (entry.method == 0)
+		{
+			data.swap(compressed);
+		}
+		else if (!inflate(compressed, data, entry.size))
+		{
+			skip(entry.name, "corrupt compressed data");
+			continue;
+		}
+
+		if (crc32(crc32(0, NULL, 0), (const Bytef *)data.data(), data.size()) != entry.crc)
+		{
+			skip(entry.name, "crc mismatch");
+			continue;
+		}
+
+		name = entry.name;
+		return true;
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+void ZipReader::directory()
+{
+	m_file.seekg(0, ios::end);
+	uint64_t file_size = m_file.tellg();
+
+	if (file_size < END_SIZE)
+	{
+		throw runtime_error(string("Corrupt archive ") + m_path);
+	}
+
+	// Find end of central directory record scanning back over comment
+	size_t tail_size = (size_t)min<uint64_t>(file_size, END_SIZE + MAX_COMMENT);
+	string tail(tail_size, '\0');
+	read(file_size - tail_size, &tail[0], tail_size);
+
+	size_t end = string::npos;
+	for (size_t i = tail_size - END_SIZE + 1; i-- > 0; )
+	{
+		if (u32(&tail[i]) == END_OF_DIRECTORY)
+		{
+			end = i;
+			break;
+		}
+	}
+
+	if (end == string::npos)
+	{
+		throw runtime_error(string("Corrupt archive ") + m_path);
+	}
+
+	uint64_t count = u16(&tail[end + 10]);
+	uint64_t dir_size = u32(&tail[end + 12]);
+	uint64_t dir_offset = u32(&tail[end + 16]);
+
+	// Zip64 locator precedes end record
+	uint64_t end_offset = file_size - tail_size + end;
+	if (end_offset >= 20)
+	{
+		char locator[20];
+		read(end_offset - 20, locator, sizeof(locator));
+
+		if (u32(locator) == ZIP64_LOCATOR)
+		{
+			char record[56];
+			read(u64(locator + 8), record, sizeof(record));
+
+			if (u32(record) != ZIP64_END_OF_DIRECTORY)
+			{
+				throw runtime_error(string("Corrupt zip64 archive ") + m_path);
+			}
+
+			count = u64(record + 32);
+			dir_size = u64(record + 40);
+			dir_offset = u64(record + 48);
+		}
+	}
+
+	// Directory precedes end records, checked before anything is allocated
+	if (dir_size > end_offset || dir_offset > end_offset - dir_size)
+	{
+		throw runtime_error(string("Corrupt central directory in archive ") + m_path);
+	}
+
+	m_dir_offset = dir_offset;
+
+	string dir((size_t)dir_size, '\0');
+	if (dir_size)
+	{
+		read(dir_offset, &dir[0], dir.size());
+	}
+
+	size_t pos = 0;
+	for (uint64_t i = 0; i < count; ++i)
+	{
+		if (pos + 46 > dir.size() || u32(&dir[pos]) != CENTRAL_HEADER)
+		{
+			throw runtime_error(string("Corrupt central directory in archive ") + m_path);
+		}
+
+		const char *record = &dir[pos];
+		uint16_t flags = u16(record + 8);
+		size_t name_length = u16(record + 28);
+		size_t extra_length = u16(record + 30);
+		size_t comment_length = u16(record + 32);
+
+		if (pos + 46 + name_length + extra_length + comment_length > dir.size())
+		{
+			throw runtime_error(string("Corrupt central directory in archive ") + m_path);
+		}
+
+		Entry entry;
+		entry.name.assign(record + 46, name_length);
+		entry.method = u16(record + 10);
+		entry.crc = u32(record + 16);
+		entry.compressed = u32(record + 20);
+		entry.size = u32(record + 24);
+		entry.offset = u32(record + 42);
+
+		// Zip64 extra field holds values saturated in the record, in fixed order
+		const char *extra = record + 46 + name_length;
+		for (size_t e = 0; e + 4 <= extra_length; )
+		{
+			uint16_t id = u16(extra + e);
+			uint16_t length = u16(extra + e + 2);
+			const char *field = extra + e + 4;
+			const char *field_end = field + min<size_t>(length, extra_length - e - 4);
+
+			if (id == 0x0001)
+			{
+				if (entry.size == 0xffffffff && field + 8 <= field_end)
+				{
+					entry.size = u64(field);
+					field += 8;
+				}
+
+				if (entry.compressed == 0xffffffff && field + 8 <= field_end)
+				{
+					entry.compressed = u64(field);
+					field += 8;
+				}
+
+				if (entry.offset == 0xffffffff && field + 8 <= field_end)
+				{
+					entry.offset = u64(field);
+				}
+			}
+
+			e += 4 + length;
+		}
+
+		pos += 46 + name_length + extra_length + comment_length;
+
+		// Skip directories silently, other entries which can not be read with reason
+		bool directory = !entry.name.empty() && entry.name[entry.name.size() - 1] == '/';
+		if (directory)
+		{
+			continue;
+		}
+
+		string original = entry.name;
+		if (!sanitize(entry.name))
+		{
+			skip(original, "unsafe name");
+		}
+		else if (flags & 0x1)
+		{
+			skip(entry.name, "encrypted");
+		}
+		else if (entry.method != 0 && entry.method != 8)
+		{
+			ostringstream reason;
+			reason << "unsupported compression method " << entry.method;
+			skip(entry.name, reason.str());
+		}
+		else if (entry.size > MAX_ENTRY || entry.compressed > MAX_ENTRY)
+		{
+			skip(entry.name, "larger than 2 GB");
+		}
+		else if (entry.offset > dir_offset || entry.compressed > dir_offset - entry.offset)
+		{
+			skip(entry.name, "data outside of archive");
+		}
+		else
+		{
+			m_entries.push_back(entry);
+		}
+	}
+
+	// Read front to back
+	stable_sort(m_entries.begin(), m_entries.end());
+}
+
+//-----------------------------------------------------------------------------
+void ZipReader::read(uint64_t offset, char *buffer, size_t length)
+{
+	m_file.clear();
+	m_file.seekg(offset);
+	m_file.read(buffer, length);
+
+	if ((size_t)m_file.gcount() != length)
+	{
+		throw runtime_error(string("Truncated archive ") + m_path);
+	}
+}
+
+//-----------------------------------------------------------------------------
+bool ZipReader::inflate(const string &compressed, string &data, uint64_t size) const
+{
+	data.resize((size_t)size);
+	if (data.empty())
+	{
+		return true;
+	}
+
+	z_stream stream;
+	stream.zalloc = Z_NULL;
+	stream.zfree = Z_NULL;
+	stream.opaque = Z_NULL;
+	stream.next_in = (Bytef *)compressed.data();
+	stream.avail_in = compressed.size();
+	stream.next_out = (Bytef *)&data[0];
+	stream.avail_out = data.size();
+
+	// Negative window bits, zip entries are raw deflate streams
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+	{
+		throw runtime_error(string("Can not inflate archive ") + m_path);
+	}
+
+	int result = ::inflate(&stream, Z_FINISH);
+	inflateEnd(&stream);
+
+	return result == Z_STREAM_END && stream.total_out == size;
+}
+
+//-----------------------------------------------------------------------------
+uint16_t ZipReader::u16(const char *data)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	return bytes[0] | (bytes[1] << 8);
+}
+
+//-----------------------------------------------------------------------------
+uint32_t ZipReader::u32(const char *data)
+{
+	return u16(data) | ((uint32_t)u16(data + 2) << 16);
+}
+
+//-----------------------------------------------------------------------------
+uint64_t ZipReader::u64(const char *data)
+{
+	return u32(data) | ((uint64_t)u32(data + 4) << 32);
+}
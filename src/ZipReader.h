@@ -0,0 +1,97 @@
+#ifndef _ZIP_READER_H
+#define _ZIP_READER_H 
+
+#include "ArchiveReader.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#include <stdint.h>
+
+/**
+ * Reader of zip archives (stored and deflated entries, zip64). 
+ * Central directory is read first, then entries are read in order 
+ * of their offsets, so the archive is scanned once front to back.
+ */
+class ZipReader
+	:public ArchiveReader
+{
+public:
+	/**
+	 * Open archive and read central directory
+	 */
+	ZipReader(const std::string &path);
+
+	/**
+	 * Destructor
+	 */
+	virtual ~ZipReader();
+
+public:
+	/**
+	 * Read next regular file entry, corrupt entries are skipped
+	 * @throws std::runtime_error if archive is truncated.
+	 */
+	virtual bool next(std::string &name, std::string &data);
+
+private:
+	ZipReader(const ZipReader &);
+
+	// Central directory record
+	struct Entry
+	{
+		// Sanitized name
+		std::string name;
+
+		// Compression method, 0 stored, 8 deflated
+		uint16_t method;
+
+		// CRC-32 of content
+		uint32_t crc;
+
+		// Compressed size
+		uint64_t compressed;
+
+		// Uncompressed size
+		uint64_t size;
+
+		// Offset of local header
+		uint64_t offset;
+
+		// Ordered by offset
+		bool operator<(const Entry &other) const;
+	};
+
+	// Read central directory
+	void directory();
+
+	// Read bytes at offset
+	void read(uint64_t offset, char *buffer, size_t length);
+
+	// Inflate raw deflate stream, false if stream is corrupt
+	bool inflate(const std::string &compressed, std::string &data, uint64_t size) const;
+
+	// Little endian field readers
+	static uint16_t u16(const char *data);
+	static uint32_t u32(const char *data);
+	static uint64_t u64(const char *data);
+
+private:
+	// Archive path
+	std::string m_path;
+
+	// Archive stream
+	std::ifstream m_file;
+
+	// Offset of central directory, entry data lies before it
+	uint64_t m_dir_offset;
+
+	// Entries ordered by offset
+	std::vector<Entry> m_entries;
+
+	// Next entry index
+	size_t m_next;
+};
+
+#endif
@@ -1,14 +1,24 @@
 
 #include <string>
+#include <iostream>
 #include <fstream>
+#include <sstream>
 #include <sys/time.h>
 
 #include <boost/filesystem.hpp>
-
-#include <GraphicsMagick/Magick++.h>
+#include <boost/scoped_ptr.hpp>
 
 #include "Config.h"
-#include "ImageResizer.h"
+#include "Batch.h"
+#include "ArchiveReader.h"
+#include "Estimator.h"
+#include "Limits.h"
+#include "Prefetcher.h"
+#include "Processor.h"
+#include "PackReader.h"
+#include "Stats.h"
+#include "Metrics.h"
+#include "Trace.h"
 #include "Version.h"
 
 namespace po = boost::program_options;
@@ -27,6 +37,120 @@ double utcms()
     return tim.tv_sec * 1000.0 + (tim.tv_usec / 1000.0);
 }
 
+/**
+ * Write pack entry to stdout
+ */
+int extract(const Config &conf)
+{
+	string data;
+
+	try
+	{
+		PackReader reader(conf.packFile());
+
+		if (!reader.read(conf.extractEntry(), data))
+		{
+			if (conf.isVerbose())
+			{
+				cout << "Entry " << conf.extractEntry() << " not found\n";
+			}
+
+			return -1;
+		}
+	}
+	catch (std::exception &ex)
+	{
+		cerr << "Exception: " << ex.what() << "\n";
+		return -1;
+	}
+
+	cout.write(data.data(), data.size());
+	cout.flush();
+
+	return 0;
+}
+
+/**
+ * Resize image from stdin to stdout. Single result is written as is, 
+ * several results as frames "<alias> <format> <length>\n<data>". 
+ * Exif info goes to --exif-out file, or to "meta" frame with --meta.
+ * Sizes not produced are reported on stderr, fails if the only size is missing.
+ */
+int filter(const Config &conf)
+{
+	ostringstream input;
+	input << cin.rdbuf();
+	string data = input.str();
+
+	ResizeOptions options = conf.resizeOptions();
+	options.metaEnabled(conf.isMetaEnabled() || !conf.exifOut().empty());
+
+	Processor processor(conf.sizes(), options);
+	Processor::OutputList outputs;
+
+	try
+	{
+		Limits::Deadline deadline("file", conf.fileTimeout());
+		outputs = processor.resize(data.data(), data.size());
+	}
+	catch (std::exception &ex)
+	{
+		cerr << "Exception: " << ex.what() << "\n";
+		return -1;
+	}
+
+	// Exif info is the last output
+	if (!conf.exifOut().empty())
+	{
+		ofstream exif(conf.exifOut().c_str(), ios::out | ios::binary);
+		exif << outputs.back().blob;
+		exif.flush();
+
+		outputs.pop_back();
+	}
+
+	// Sizes can be skipped by resizer, e.g. when upscale is disabled
+	vector<Size> sizes = conf.sizes();
+	int missing = 0;
+	for (int i = 0; i < sizes.size(); ++i)
+	{
+		bool found = false;
+		for (int j = 0; j < outputs.size() && !found; ++j)
+		{
+			found = outputs[j].alias == sizes[i].alias();
+		}
+
+		if (!found)
+		{
+			cerr << "Size " << sizes[i].alias() << " is not produced\n";
+			missing++;
+		}
+	}
+
+	if (outputs.empty() || (sizes.size() == 1 && missing))
+	{
+		cerr << "No resized image produced\n";
+		return -1;
+	}
+
+	if (outputs.size() == 1 && conf.sizes().size() == 1)
+	{
+		cout.write(outputs[0].blob.data(), outputs[0].blob.size());
+	}
+	else
+	{
+		for (int i = 0; i < outputs.size(); ++i)
+		{
+			cout << outputs[i].alias << " " << outputs[i].format << " " << outputs[i].blob.size() << "\n";
+			cout.write(outputs[i].blob.data(), outputs[i].blob.size());
+		}
+	}
+
+	cout.flush();
+
+	return cout.good() ? 0 : -1;
+}
+
 /**
  * Entry point
  */
@@ -54,12 +178,38 @@ int main(int argc, char const *argv[])
 		return -1;
 	}
 
+	if (conf.command() == "extract")
+	{
+		return extract(conf);
+	}
+
+	if (conf.command() == "filter")
+	{
+		return filter(conf);
+	}
+
 	if (conf.isVerbose())
 	{
 		cout << "Config params:\n";
 		cout << "source = " << conf.source() << "\n";
 		cout << "dest = " << conf.dest() << "\n";
 		cout << "src-size = " << conf.sourceSize() << "\n";
+		cout << "quality-tier = " << conf.qualityTier() << "\n";
+		cout << "pyramid = " << conf.isPyramidEnabled() << "\n";
+		cout << "pack = " << conf.packScope() << "\n";
+		cout << "shard-levels = " << conf.shardLevels() << "\n";
+		cout << "trace = " << conf.traceFile() << "\n";
+		cout << "jobs = " << conf.jobs() << "\n";
+		cout << "auto-threads = " << conf.isAutoThreads() << "\n";
+		cout << "numa = " << conf.isNuma() << "\n";
+		cout << "prefetch = " << conf.prefetchDepth() << "\n";
+		cout << "schedule = " << conf.schedule() << "\n";
+		cout << "metrics-file = " << conf.metricsFile() << "\n";
+		cout << "master-cache = " << conf.masterCache() << "\n";
+		cout << "max-megapixels = " << conf.maxPixels() / 1e6 << "\n";
+		cout << "decode-timeout = " << conf.decodeTimeout() << "\n";
+		cout << "file-timeout = " << conf.fileTimeout() << "\n";
+		cout << "quarantine = " << conf.quarantine() << "\n";
 
 		for (int i = 0; i < conf.sizes().size(); ++i)
 		{
@@ -67,114 +217,114 @@ int main(int argc, char const *argv[])
 		}
 	}
 		
+    if (!conf.traceFile().empty())
+    {
+        Trace::instance().enable();
+    }
+
+    if (!conf.metricsFile().empty())
+    {
+        Metrics::instance().enable();
+    }
+
     path_vector files;                                			
 
-    // Copy paths of files form input directory to 'files' vector and then sort
-    copy(fs::directory_iterator(conf.source()), fs::directory_iterator(), back_inserter(files));
-    sort(files.begin(), files.end());
+    // Archive entries are streamed, directory is listed upfront
+    ArchiveReader::AutoPtr archive;
+    if (fs::is_regular_file(conf.source()))
+    {
+        archive = ArchiveReader::create(conf.source());
+    }
+    else
+    {
+        Trace::Span span("list", "io");
+        span.arg("path", conf.source());
 
-    vector<Size> sizes = conf.sizes();
-    for (int i = 0; i < sizes.size(); ++i)
+        // Copy paths of files form input directory to 'files' vector and then sort
+        copy(fs::directory_iterator(conf.source()), fs::directory_iterator(), back_inserter(files));
+        sort(files.begin(), files.end());
+    }
+
+    if (conf.isEstimate())
     {
-    	// Make output path
-		fs::path out_dir = fs::path(conf.dest()) / sizes[i].alias();
-		fs::create_directories(out_dir);
+        Estimator estimator(conf);
+        estimator.run(files, cout);
+
+        return 0;
     }
 
-    fs::path meta_path = fs::path(conf.dest()) / "meta";
-    fs::path contents_path = fs::path(conf.dest()) / "contents";
+    Processor processor(conf.sizes(), conf.resizeOptions());
+    processor.prepare(conf.dest(), !conf.packScope().empty());
 
-    if (conf.isMetaEnabled())
+    // Packs are closed (and indexes written) after the run, 
+    // store destructor only closes them on early returns
+    boost::scoped_ptr<PackStore> packs;
+    if (!conf.packScope().empty())
     {
-        // Make exif meta path        
-        fs::create_directories(meta_path);
+        packs.reset(new PackStore(conf.dest(), conf.packScope()));
     }
 
-    if (conf.isContentsEnabled())
+    Batch batch(conf, processor, packs.get());
+    batch.schedule(files);
+
+    boost::scoped_ptr<Prefetcher> prefetcher;
+    if (conf.prefetchDepth() > 0 && !archive)
     {
-        // Make contents path        
-        fs::create_directories(contents_path);
+        prefetcher.reset(new Prefetcher(files, conf.prefetchDepth(), conf.prefetchBudget(), conf.isPrefetchBuffer()));
+        batch.prefetcher(prefetcher.get());
     }
 
     double start = utcms();
 
-	// Iterate throught input directory files
-    for (path_vector::const_iterator it(files.begin()); it != files.end(); ++it)
+    if (!conf.metricsFile().empty())
+    {
+        Metrics::instance().start(conf.metricsFile(), conf.metricsInterval());
+    }
+
+    bool result = archive ? batch.run(*archive) : batch.run(files);
+
+    if (packs)
     {
-    	string file_path = fs::absolute(*it).native();
-
-    	// Skip directories
-    	if (!fs::is_regular_file(file_path))
-    	{
-    		continue;
-    	}
-
-    	if (conf.isVerbose())
-    	{
-    		cout << "Process " << file_path << " file\n";      	
-    	}
-    	
-    	try
-    	{
-            // Create resizer
-    		ImageResizer::AutoPtr resizer = ImageResizer::create(file_path, conf);
-            vector<string> contents;
-
-            if (conf.isMetaEnabled())
-            {
-                fs::path meta_file = meta_path / it->filename();
-                string meta = fs::absolute(meta_file).replace_extension(".exif").native();
-
-                // Add to contents
-                contents.push_back(string("meta=") + meta);
-
-                // Write exif infometa_file
-                resizer->writeExif(meta);
-            }
-
-            for (int i = 0; i < sizes.size(); ++i)
-            {
-                fs::path out_path = fs::path(conf.dest()) / sizes[i].alias() / it->filename();
-                string dest = fs::absolute(out_path).native();
-
-                // Add to contents
-                contents.push_back(sizes[i].alias() + "=" + dest);
-
-                // Resize
-                resizer->resize(dest, sizes[i]);
-            }
-
-            // Write contents
-            if (conf.isContentsEnabled())
-            {
-                fs::path contents_file = fs::absolute(contents_path / it->filename()).replace_extension(".cnt");
-
-                ofstream cnt_fstream(contents_file.native().c_str(), ios::out);
-                for (int i = 0; i < contents.size(); ++i)
-                {
-                    cnt_fstream << contents[i] << "\n";
-                }
-
-                cnt_fstream.flush();
-            }
-    	}
-    	catch(std::runtime_error &ex) 
-    	{
-    		if (conf.isVerbose()) 
-    		{
-    			cout << "Exception: " << ex.what() << "\n";    			
-    		}
-
-    		return -1;
-    	}    	
+        try
+        {
+            packs->close();
+        }
+        catch (std::exception &ex)
+        {
+            cerr << "Exception: " << ex.what() << "\n";
+            result = false;
+        }
     }
 
+    // Final metrics are written on stop, trace is kept for failed runs too
+    Metrics::instance().stop();
+
     double end = utcms();
 
+    if (!conf.traceFile().empty() && !Trace::instance().write(conf.traceFile()) && conf.isVerbose())
+    {
+        cout << "Can not write trace to " << conf.traceFile() << "\n";
+    }
+
+    if (!result)
+    {
+        return -1;
+    }
+
     if (conf.isVerbose())
     {
     	cout << "Time spent: " << (int)(end - start) << " ms\n";
     }
+
+    if (conf.isStatsEnabled() || conf.isVerbose())
+    {
+        Stats::instance().print(cout);
+
+        if (prefetcher)
+        {
+            prefetcher->print(cout);
+        }
+    }
 	
 	return 0;
 }
@@ -0,0 +1,249 @@
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+
+#include "ArchiveReader.h"
+
+namespace fs = boost::filesystem;
+
+using namespace std;
+
+/**
+ * Archive reader tests over fixtures in test/fixtures, 
+ * regenerated by test/fixtures/make_fixtures.py.
+ * Usage: archive_test <fixtures directory> <case>
+ */
+
+// Entry name and content
+typedef vector<pair<string, string> > EntryList;
+
+static const string CONTENT = "not really a jpeg, but archive readers do not care\n";
+static const string LONG_NAME = "deep/" + string(120, 'd') + "/image-with-a-rather-long-name.jpg";
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void check(bool condition, const char *text, int line)
+{
+	if (!condition)
+	{
+		cout << "line " << line << ": check failed: " << text << "\n";
+		failures++;
+	}
+}
+
+string repeat(const string &value, int count)
+{
+	string result;
+	for (int i = 0; i < count; ++i)
+	{
+		result += value;
+	}
+
+	return result;
+}
+
+/**
+ * Read all entries, collecting skipped entry messages
+ */
+EntryList readAll(const string &path, vector<string> &skipped)
+{
+	ArchiveReader::AutoPtr archive = ArchiveReader::create(path);
+	if (!archive)
+	{
+		throw runtime_error(string("Not an archive ") + path);
+	}
+
+	EntryList entries;
+	string name;
+	string data;
+
+	while (true)
+	{
+		bool found = archive->next(name, data);
+
+		vector<string> messages = archive->takeSkipped();
+		skipped.insert(skipped.end(), messages.begin(), messages.end());
+
+		if (!found)
+		{
+			break;
+		}
+
+		entries.push_back(make_pair(name, data));
+	}
+
+	return entries;
+}
+
+bool contains(const vector<string> &messages, const string &message)
+{
+	for (size_t i = 0; i < messages.size(); ++i)
+	{
+		if (messages[i] == message)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool throws(const string &path)
+{
+	try
+	{
+		vector<string> skipped;
+		readAll(path, skipped);
+	}
+	catch (std::runtime_error &)
+	{
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Tar with directory, symlink, long name and unsafe name: 
+ * only regular files with safe names are returned
+ */
+void tarEntries(const string &path, bool unsafe)
+{
+	vector<string> skipped;
+	EntryList entries = readAll(path, skipped);
+
+	CHECK(entries.size() == 2);
+	if (entries.size() == 2)
+	{
+		CHECK(entries[0].first == "a/b.jpg");
+		CHECK(entries[0].second == CONTENT);
+		CHECK(entries[1].first == LONG_NAME);
+		CHECK(entries[1].second == repeat(CONTENT, 20));
+	}
+
+	CHECK(!unsafe || contains(skipped, "../evil.jpg: unsafe name"));
+	CHECK(skipped.size() == (unsafe ? 1 : 0));
+}
+
+/**
+ * Zip with deflated, stored, bzip2, encrypted and unsafe entries
+ */
+void zipEntries(const string &path, bool zip64)
+{
+	vector<string> skipped;
+	EntryList entries = readAll(path, skipped);
+
+	CHECK(entries.size() == 2);
+	if (entries.size() == 2)
+	{
+		CHECK(entries[0].first == "a/b.jpg");
+		CHECK(entries[0].second == repeat(CONTENT, 20));
+		CHECK(entries[1].first == "stored.jpg");
+		CHECK(entries[1].second == CONTENT);
+	}
+
+	if (!zip64)
+	{
+		CHECK(skipped.size() == 3);
+		CHECK(contains(skipped, "bzip2.jpg: unsupported compression method 12"));
+		CHECK(contains(skipped, "secret.jpg: encrypted"));
+		CHECK(contains(skipped, "../evil.jpg: unsafe name"));
+	}
+}
+
+/**
+ * Zip with corrupt entries between good ones: corrupt entries are 
+ * skipped, entries after them are still read
+ */
+void corruptEntries(const string &path)
+{
+	vector<string> skipped;
+	EntryList entries = readAll(path, skipped);
+
+	CHECK(entries.size() == 2);
+	if (entries.size() == 2)
+	{
+		CHECK(entries[0].first == "a/b.jpg");
+		CHECK(entries[0].second == repeat(CONTENT, 20));
+		CHECK(entries[1].first == "stored.jpg");
+		CHECK(entries[1].second == CONTENT);
+	}
+
+	CHECK(skipped.size() == 3);
+	CHECK(contains(skipped, "crc.jpg: crc mismatch"));
+	CHECK(contains(skipped, "deflate.jpg: corrupt compressed data"));
+	CHECK(contains(skipped, "header.jpg: corrupt local header"));
+}
+
+/**
+ * Entry point
+ */
+int main(int argc, char const *argv[])
+{
+	if (argc != 3)
+	{
+		cout << "Usage: archive_test <fixtures directory> <case>\n";
+		return 1;
+	}
+
+	fs::path fixtures(argv[1]);
+	string name = argv[2];
+
+	try
+	{
+		if (name == "gnu_tar")
+		{
+			tarEntries((fixtures / "gnu.tar").native(), true);
+		}
+		else if (name == "pax_tar")
+		{
+			tarEntries((fixtures / "pax.tar").native(), true);
+		}
+		else if (name == "ustar_tar")
+		{
+			tarEntries((fixtures / "ustar.tar").native(), false);
+		}
+		else if (name == "gnu_tgz")
+		{
+			tarEntries((fixtures / "gnu.tgz").native(), true);
+		}
+		else if (name == "truncated_tar")
+		{
+			CHECK(throws((fixtures / "truncated.tar").native()));
+		}
+		else if (name == "plain_zip")
+		{
+			zipEntries((fixtures / "plain.zip").native(), false);
+		}
+		else if (name == "zip64_zip")
+		{
+			zipEntries((fixtures / "zip64.zip").native(), true);
+		}
+		else if (name == "huge_dir_zip")
+		{
+			CHECK(throws((fixtures / "huge-dir.zip").native()));
+		}
+		else if (name == "corrupt_entries_zip")
+		{
+			corruptEntries((fixtures / "corrupt-entries.zip").native());
+		}
+		else
+		{
+			cout << "Unknown case " << name << "\n";
+			return 1;
+		}
+	}
+	catch (std::exception &ex)
+	{
+		cout << "Exception: " << ex.what() << "\n";
+		return 1;
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Regenerate archive fixtures of archive_test. Output is deterministic."""
+
+import gzip
+import io
+import os
+import struct
+import tarfile
+import zlib
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+LONG_NAME = "deep/" + "d" * 120 + "/image-with-a-rather-long-name.jpg"
+CONTENT = b"not really a jpeg, but archive readers do not care\n"
+
+
+def tar_bytes(fmt, members):
+    out = io.BytesIO()
+    with tarfile.open(fileobj=out, mode="w", format=fmt) as tar:
+        for name, kind, data in members:
+            info = tarfile.TarInfo(name)
+            info.mtime = 0
+            if kind == "dir":
+                info.type = tarfile.DIRTYPE
+                tar.addfile(info)
+            elif kind == "link":
+                info.type = tarfile.SYMTYPE
+                info.linkname = "a.jpg"
+                tar.addfile(info)
+            else:
+                info.size = len(data)
+                tar.addfile(info, io.BytesIO(data))
+    return out.getvalue()
+
+
+def write(name, data):
+    with open(os.path.join(HERE, name), "wb") as f:
+        f.write(data)
+
+
+def zip_bytes(entries, zip64=False, dir_size=None):
+    """entries: (name, method, data, flags), method 0 stored, 8 deflated, others raw"""
+    out = bytearray()
+    central = bytearray()
+    for name, method, data, flags in entries:
+        raw = name.encode()
+        if method == 8:
+            c = zlib.compressobj(9, zlib.DEFLATED, -15)
+            payload = c.compress(data) + c.flush()
+        else:
+            payload = data
+        crc = zlib.crc32(data) & 0xffffffff
+        offset = len(out)
+        out += struct.pack("<IHHHHHIIIHH", 0x04034b50, 20, flags, method, 0, 0,
+                           crc, len(payload), len(data), len(raw), 0) + raw + payload
+        if zip64:
+            extra = struct.pack("<HHQQQ", 1, 24, len(data), len(payload), offset)
+            sizes = (0xffffffff, 0xffffffff, 0xffffffff)
+        else:
+            extra = b""
+            sizes = (len(payload), len(data), offset)
+        central += struct.pack("<IHHHHHHIIIHHHHHII", 0x02014b50, 45, 45, flags, method, 0, 0,
+                               crc, sizes[0], sizes[1], len(raw), len(extra), 0, 0, 0, 0,
+                               sizes[2]) + raw + extra
+    dir_offset = len(out)
+    out += central
+    size = len(central) if dir_size is None else dir_size
+    if zip64:
+        record_offset = len(out)
+        out += struct.pack("<IQHHIIQQQQ", 0x06064b50, 44, 45, 45, 0, 0,
+                           len(entries), len(entries), size, dir_offset)
+        out += struct.pack("<IIQI", 0x07064b50, 0, record_offset, 1)
+        out += struct.pack("<IHHHHIIH", 0x06054b50, 0, 0, 0xffff, 0xffff,
+                           0xffffffff, 0xffffffff, 0)
+    else:
+        out += struct.pack("<IHHHHIIH", 0x06054b50, 0, 0, len(entries), len(entries),
+                           size, dir_offset, 0)
+    return bytes(out)
+
+
+def main():
+    members = [
+        ("a", "dir", None),
+        ("a/b.jpg", "file", CONTENT),
+        ("a/link.jpg", "link", None),
+        (LONG_NAME, "file", CONTENT * 20),
+        ("../evil.jpg", "file", CONTENT),
+    ]
+
+    write("gnu.tar", tar_bytes(tarfile.GNU_FORMAT, members))
+    write("pax.tar", tar_bytes(tarfile.PAX_FORMAT, members))
+    write("ustar.tar", tar_bytes(tarfile.USTAR_FORMAT, members[:4]))
+
+    gz = io.BytesIO()
+    with gzip.GzipFile(fileobj=gz, mode="wb", mtime=0) as f:
+        f.write(tar_bytes(tarfile.GNU_FORMAT, members))
+    write("gnu.tgz", gz.getvalue())
+
+    truncated = tar_bytes(tarfile.GNU_FORMAT, members)
+    write("truncated.tar", truncated[:512 * 3 + 100])
+
+    entries = [
+        ("a/", 0, b"", 0),
+        ("a/b.jpg", 8, CONTENT * 20, 0),
+        ("stored.jpg", 0, CONTENT, 0),
+        ("bzip2.jpg", 12, b"BZh9", 0),
+        ("secret.jpg", 0, CONTENT, 1),
+        ("../evil.jpg", 0, CONTENT, 0),
+    ]
+    write("plain.zip", zip_bytes(entries))
+    write("zip64.zip", zip_bytes(entries[:3], zip64=True))
+    write("huge-dir.zip", zip_bytes(entries[:3], zip64=True, dir_size=1 << 62))
+
+    # Corrupt entries between good ones: flipped data byte, broken deflate
+    # stream and broken local header signature
+    corrupt = bytearray(zip_bytes([
+        ("a/b.jpg", 8, CONTENT * 20, 0),
+        ("crc.jpg", 0, CONTENT, 0),
+        ("deflate.jpg", 8, CONTENT * 20, 0),
+        ("header.jpg", 0, CONTENT, 0),
+        ("stored.jpg", 0, CONTENT, 0),
+    ]))
+    corrupt[corrupt.index(b"crc.jpg") + len("crc.jpg")] ^= 0xff
+    corrupt[corrupt.index(b"deflate.jpg") + len("deflate.jpg")] = 0xff
+    corrupt[corrupt.index(b"header.jpg") - 30] ^= 0xff
+    write("corrupt-entries.zip", bytes(corrupt))
+
+
+if __name__ == "__main__":
+    main()
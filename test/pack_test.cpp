@@ -0,0 +1,239 @@
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <signal.h>
+#include <sys/resource.h>
+
+#include <boost/filesystem.hpp>
+
+#include "Pack.h"
+#include "PackWriter.h"
+#include "PackReader.h"
+
+namespace fs = boost::filesystem;
+
+using namespace std;
+
+/**
+ * Pack reader tests, packs are written to and corrupted in a work directory.
+ * Usage: pack_test <work directory> <case>
+ */
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void check(bool condition, const char *text, int line)
+{
+	if (!condition)
+	{
+		cout << "line " << line << ": check failed: " << text << "\n";
+		failures++;
+	}
+}
+
+/**
+ * Write pack with three entries, returns pack path without extension
+ */
+string writePack(const fs::path &dir, const string &name)
+{
+	fs::create_directories(dir);
+
+	string path = (dir / name).native();
+	fs::remove(path + Pack::DATA_EXTENSION);
+	fs::remove(path + Pack::INDEX_EXTENSION);
+
+	PackWriter writer(path);
+	writer.add("b/small.jpg", "JPEG", "small");
+	writer.add("a/large.jpg", "JPEG", string(1000, 'x'));
+	writer.add("c/meta.txt", "TEXT", "Orientation=1\n");
+	writer.close();
+
+	return path;
+}
+
+/**
+ * Overwrite bytes of file at offset
+ */
+void patch(const string &path, uint64_t offset, const void *data, size_t length)
+{
+	fstream file(path.c_str(), ios::in | ios::out | ios::binary);
+	file.seekp(offset);
+	file.write(static_cast<const char *>(data), length);
+	if (!file)
+	{
+		throw runtime_error("Can not patch " + path);
+	}
+}
+
+bool throws(const string &path)
+{
+	try
+	{
+		PackReader reader(path);
+	}
+	catch (std::runtime_error &)
+	{
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Entries are sorted by name and read back
+ */
+void roundTrip(const fs::path &dir)
+{
+	PackReader reader(writePack(dir, "round-trip"));
+
+	CHECK(reader.size() == 3);
+	CHECK(reader.name(0) == "a/large.jpg");
+	CHECK(reader.name(2) == "c/meta.txt");
+
+	string data;
+	CHECK(reader.read("a/large.jpg", data) && data == string(1000, 'x'));
+	CHECK(reader.read("b/small.jpg", data) && data == "small");
+	CHECK(reader.read("c/meta.txt", data) && data == "Orientation=1\n");
+	CHECK(!reader.read("d/missing.jpg", data));
+
+	Pack::Entry entry;
+	CHECK(reader.find("c/meta.txt", entry) && entry.format == "TEXT");
+}
+
+/**
+ * Index cut inside of records
+ */
+void truncatedIndex(const fs::path &dir)
+{
+	string path = writePack(dir, "truncated-index");
+	fs::resize_file(path + Pack::INDEX_EXTENSION, sizeof(Pack::IndexHeader) + sizeof(Pack::IndexRecord) / 2);
+
+	CHECK(throws(path));
+}
+
+/**
+ * Record name pointing past the end of index
+ */
+void badNameOffset(const fs::path &dir)
+{
+	string path = writePack(dir, "bad-name-offset");
+	uint64_t name_offset = 1ULL << 40;
+	patch(path + Pack::INDEX_EXTENSION, sizeof(Pack::IndexHeader) + sizeof(Pack::IndexRecord), &name_offset, sizeof(name_offset));
+
+	CHECK(throws(path));
+}
+
+/**
+ * Data file shorter than entries listed in index
+ */
+void truncatedData(const fs::path &dir)
+{
+	string path = writePack(dir, "truncated-data");
+	fs::resize_file(path + Pack::DATA_EXTENSION, 100);
+
+	CHECK(throws(path));
+}
+
+/**
+ * Entry write failing half way (file size limit) leaves no partial data 
+ * behind, so offsets of next entries stay right
+ */
+void partialWrite(const fs::path &dir)
+{
+	fs::create_directories(dir);
+
+	string path = (dir / "partial-write").native();
+	fs::remove(path + Pack::DATA_EXTENSION);
+	fs::remove(path + Pack::INDEX_EXTENSION);
+
+	signal(SIGXFSZ, SIG_IGN);
+
+	rlimit saved;
+	getrlimit(RLIMIT_FSIZE, &saved);
+
+	PackWriter writer(path);
+	writer.add("a.jpg", "JPEG", "first");
+
+	rlimit limited = saved;
+	limited.rlim_cur = 100;
+	setrlimit(RLIMIT_FSIZE, &limited);
+
+	bool failed = false;
+	try
+	{
+		writer.add("b.jpg", "JPEG", string(1000, 'b'));
+	}
+	catch (std::runtime_error &)
+	{
+		failed = true;
+	}
+
+	setrlimit(RLIMIT_FSIZE, &saved);
+
+	CHECK(failed);
+	CHECK(fs::file_size(path + Pack::DATA_EXTENSION) == 5);
+
+	writer.add("c.jpg", "JPEG", "third");
+	writer.close();
+
+	PackReader reader(path);
+	string data;
+	CHECK(reader.size() == 2);
+	CHECK(reader.read("a.jpg", data) && data == "first");
+	CHECK(reader.read("c.jpg", data) && data == "third");
+	CHECK(!reader.read("b.jpg", data));
+}
+
+/**
+ * Entry point
+ */
+int main(int argc, char const *argv[])
+{
+	if (argc != 3)
+	{
+		cout << "Usage: pack_test <work directory> <case>\n";
+		return 1;
+	}
+
+	fs::path dir(argv[1]);
+	string name = argv[2];
+
+	try
+	{
+		if (name == "round_trip")
+		{
+			roundTrip(dir);
+		}
+		else if (name == "truncated_index")
+		{
+			truncatedIndex(dir);
+		}
+		else if (name == "bad_name_offset")
+		{
+			badNameOffset(dir);
+		}
+		else if (name == "truncated_data")
+		{
+			truncatedData(dir);
+		}
+		else if (name == "partial_write")
+		{
+			partialWrite(dir);
+		}
+		else
+		{
+			cout << "Unknown case " << name << "\n";
+			return 1;
+		}
+	}
+	catch (std::exception &ex)
+	{
+		cout << "Exception: " << ex.what() << "\n";
+		return 1;
+	}
+
+	return failures ? 1 : 0;
+}